@@ -0,0 +1,504 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+/*
+	Load generator for ircserv. Connects bots to a server on localhost, registers them, puts every
+	bot into one of the benchmark channels and then drives a mix of PRIVMSG, JOIN, NICK and MODE
+	at a fixed rate (or as fast as the bots can write). Every PRIVMSG carries its send time, the
+	receiving bots record the end-to-end delivery latency. For JOIN, NICK and MODE the time until
+	the sender got the reply is recorded. All bots run on one epoll loop.
+
+	./ircbench --port=6667 --password=pw [--bots=100] [--channels=10] [--duration=10]
+	           [--rate=10000] [--size=64] [--mix=privmsg:90,join:4,nick:3,mode:3]
+*/
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+enum benchAction
+{
+	ACTION_PRIVMSG,
+	ACTION_JOIN,
+	ACTION_NICK,
+	ACTION_MODE,
+	ACTION_COUNT
+};
+
+static const char	*actionNames[] = {"privmsg", "join", "nick", "mode"};
+
+const int	EPOLL_BATCH = 256;
+const int	SETUP_TIMEOUT_MS = 10000;
+const int	DRAIN_IDLE_MS = 500;			// the run ends once nothing arrived for this long
+const int	DRAIN_MAX_MS = 30000;
+const size_t	BOT_OUTPUT_LIMIT = 64 * 1024;	// actions are skipped while a bot is this far behind
+
+struct BenchConfig
+{
+	int			port = 6667;
+	std::string	password;
+	int			bots = 100;
+	int			channels = 10;
+	int			duration = 10;			// seconds
+	int			rate = 10000;			// actions per second over all bots, 0 for unlimited
+	int			size = 64;				// PRIVMSG text bytes
+	int			mix[ACTION_COUNT] = {90, 4, 3, 3};
+};
+
+struct Pending
+{
+	benchAction	action;
+	uint64_t	sentAt;
+};
+
+struct Bot
+{
+	int					fd = -1;
+	int					id = 0;
+	std::string			nick;
+	unsigned			nickGeneration = 0;
+	std::string			input;
+	std::string			output;
+	bool				registered = false;
+	std::vector<int>	channels;			// joined, by number
+	std::deque<Pending>	pending;			// JOIN, NICK and MODE waiting for their reply
+	bool				closed = false;
+};
+
+struct BenchState
+{
+	BenchConfig				config;
+	int						epollFd = -1;
+	std::vector<Bot>		bots;
+	std::mt19937			random{12345};
+	std::vector<uint32_t>	latencies[ACTION_COUNT];
+	uint64_t				sent[ACTION_COUNT] = {};
+	uint64_t				delivered = 0;
+	uint64_t				errors = 0;
+	int						registeredBots = 0;
+	int						joinedBots = 0;
+	int						closedBots = 0;
+	uint64_t				lastInput = 0;
+	uint64_t				loadStart = 0;
+};
+
+static uint64_t	nowMicros()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000);
+}
+
+static std::string	channelName(int number) { return ("#bench" + std::to_string(number)); }
+
+static bool	parseInt(const std::string &value, int min, int &result)
+{
+	char *end;
+	long number = std::strtol(value.c_str(), &end, 10);
+
+	if (value.empty() || *end != '\0' || number < min || number > 1000000)
+		return (false);
+	result = static_cast<int>(number);
+	return (true);
+}
+
+/*"privmsg:90,join:4,nick:3,mode:3", actions which are left out get weight 0*/
+static bool	parseMix(const std::string &value, int *mix)
+{
+	size_t start = 0;
+
+	std::fill(mix, mix + ACTION_COUNT, 0);
+	while (start < value.size())
+	{
+		size_t end = std::min(value.find(',', start), value.size());
+		std::string pair = value.substr(start, end - start);
+		size_t colon = pair.find(':');
+		int action = 0;
+		while (action < ACTION_COUNT && pair.compare(0, colon, actionNames[action]) != 0)
+			action++;
+		if (colon == std::string::npos || action == ACTION_COUNT || !parseInt(pair.substr(colon + 1), 0, mix[action]))
+			return (false);
+		start = end + 1;
+	}
+	return (mix[ACTION_PRIVMSG] + mix[ACTION_JOIN] + mix[ACTION_NICK] + mix[ACTION_MODE] > 0);
+}
+
+static bool	parseArguments(int argc, char **argv, BenchConfig &config)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+		size_t eq = arg.find('=');
+		if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos)
+			return (false);
+		std::string key = arg.substr(2, eq - 2);
+		std::string value = arg.substr(eq + 1);
+		bool ok = (key == "port" && parseInt(value, 1, config.port))
+			|| (key == "bots" && parseInt(value, 1, config.bots))
+			|| (key == "channels" && parseInt(value, 1, config.channels))
+			|| (key == "duration" && parseInt(value, 1, config.duration))
+			|| (key == "rate" && parseInt(value, 0, config.rate))
+			|| (key == "size" && parseInt(value, 24, config.size))
+			|| (key == "mix" && parseMix(value, config.mix));
+		if (key == "password")
+		{
+			config.password = value;
+			ok = true;
+		}
+		if (!ok)
+			return (false);
+	}
+	return (!config.password.empty());
+}
+
+/*Raises the fd limit to the hard limit, every bot needs a socket*/
+static void	raiseFdLimit()
+{
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+static void	sendLine(Bot &bot, const std::string &line)
+{
+	bot.output += line;
+	bot.output += "\r\n";
+}
+
+/*Writes what the socket takes, the rest stays in the bot's output buffer*/
+static void	flushBot(BenchState &state, Bot &bot)
+{
+	while (!bot.output.empty() && !bot.closed)
+	{
+		ssize_t bytes = write(bot.fd, bot.output.data(), bot.output.size());
+		if (bytes == -1 && (errno == EAGAIN || errno == EINTR))
+			return;
+		if (bytes <= 0)
+		{
+			bot.closed = true;
+			state.closedBots++;
+			return;
+		}
+		bot.output.erase(0, bytes);
+	}
+}
+
+static bool	connectBot(BenchState &state, Bot &bot)
+{
+	sockaddr_in addr = {};
+	int one = 1;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(state.config.port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	bot.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (bot.fd == -1 || connect(bot.fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+	{
+		perror("connect");
+		return (false);
+	}
+	setsockopt(bot.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	fcntl(bot.fd, F_SETFL, O_NONBLOCK);
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.u32 = bot.id;
+	epoll_ctl(state.epollFd, EPOLL_CTL_ADD, bot.fd, &ev);
+	bot.nick = "bot" + std::to_string(bot.id);
+	sendLine(bot, "CAP LS 302");
+	sendLine(bot, "PASS " + state.config.password);
+	sendLine(bot, "NICK " + bot.nick);
+	sendLine(bot, "USER " + bot.nick + " 0 * :ircbench");
+	sendLine(bot, "CAP END");
+	flushBot(state, bot);
+	return (true);
+}
+
+/*A reply finishing the oldest pending JOIN, NICK or MODE of the bot*/
+static void	completePending(BenchState &state, Bot &bot, benchAction action, uint64_t now)
+{
+	if (bot.pending.empty() || bot.pending.front().action != action)
+		return;
+	state.latencies[action].push_back(static_cast<uint32_t>(now - bot.pending.front().sentAt));
+	bot.pending.pop_front();
+}
+
+/*Handles one line from the server, the command follows the source prefix (":localhost" for the
+  server's own lines, ":nick!user@host" for relayed ones)*/
+static void	handleLine(BenchState &state, Bot &bot, const std::string &line, uint64_t now)
+{
+	size_t start = (!line.empty() && line[0] == ':') ? line.find(' ') : std::string::npos;
+	start = (start == std::string::npos) ? 0 : start + 1;
+	size_t space = line.find(' ', start);
+	std::string first = line.substr(start, space - start);
+	std::string rest = (space == std::string::npos) ? "" : line.substr(space + 1);
+
+	if (first == "PING")
+		sendLine(bot, "PONG " + rest);
+	else if (first == "ERROR")
+		state.errors++;
+	else if (first == "001" && !bot.registered)
+	{
+		bot.registered = true;
+		state.registeredBots++;
+	}
+	else if (first == "366")
+	{
+		if (bot.pending.empty() && bot.channels.size() == 1)
+			state.joinedBots++;
+		completePending(state, bot, ACTION_JOIN, now);
+	}
+	else if (first == "324")
+		completePending(state, bot, ACTION_MODE, now);
+	else if (first == "PRIVMSG")
+	{
+		size_t text = line.find(" :");
+		if (text == std::string::npos)
+			return;
+		uint64_t sentAt = std::strtoull(line.c_str() + text + 2, nullptr, 10);
+		if (sentAt != 0 && sentAt <= now)
+			state.latencies[ACTION_PRIVMSG].push_back(static_cast<uint32_t>(now - sentAt));
+		state.delivered++;
+	}
+	else if (first == "NICK")
+	{
+		size_t nick = line.find(" NICK :");
+		std::string own = "bot" + std::to_string(bot.id) + "_";
+		if (nick != std::string::npos && line.compare(nick + 7, own.size(), own) == 0)
+			completePending(state, bot, ACTION_NICK, now);
+	}
+	else if (first.size() == 3 && first[0] == '4')
+		state.errors++;
+}
+
+static void	readBot(BenchState &state, Bot &bot, uint64_t now)
+{
+	char buffer[16384];
+
+	while (!bot.closed)
+	{
+		ssize_t bytes = read(bot.fd, buffer, sizeof(buffer));
+		if (bytes == -1 && (errno == EAGAIN || errno == EINTR))
+			break;
+		if (bytes <= 0)
+		{
+			bot.closed = true;
+			state.closedBots++;
+			break;
+		}
+		bot.input.append(buffer, bytes);
+		state.lastInput = now;
+	}
+	size_t start = 0;
+	size_t end;
+	while ((end = bot.input.find("\r\n", start)) != std::string::npos)
+	{
+		handleLine(state, bot, bot.input.substr(start, end - start), now);
+		start = end + 2;
+	}
+	bot.input.erase(0, start);
+}
+
+/*Handles the readable bots and writes their pending output, waiting at most timeoutMs*/
+static void	pollBots(BenchState &state, int timeoutMs)
+{
+	struct epoll_event events[EPOLL_BATCH];
+
+	int ready = epoll_wait(state.epollFd, events, EPOLL_BATCH, timeoutMs);
+	uint64_t now = nowMicros();
+	for (int i = 0; i < ready; i++)
+		readBot(state, state.bots[events[i].data.u32], now);
+	for (Bot &bot : state.bots)
+		flushBot(state, bot);
+}
+
+/*Runs the loop until done() returns true or timeoutMs passed. Returns done().*/
+template <typename Done>
+static bool	waitFor(BenchState &state, int timeoutMs, Done done)
+{
+	uint64_t deadline = nowMicros() + timeoutMs * 1000ULL;
+
+	while (!done() && nowMicros() < deadline)
+		pollBots(state, 10);
+	return (done());
+}
+
+/*Issues one action of the mix for the bot. Falls back to PRIVMSG for JOIN once the bot is in every
+  channel.*/
+static void	issueAction(BenchState &state, Bot &bot, int totalWeight)
+{
+	BenchConfig &config = state.config;
+	int pick = state.random() % totalWeight;
+	int action = 0;
+
+	if (bot.closed || bot.output.size() > BOT_OUTPUT_LIMIT)
+		return;
+	while (pick >= config.mix[action])
+		pick -= config.mix[action++];
+	if (action == ACTION_JOIN && static_cast<int>(bot.channels.size()) == config.channels)
+		action = ACTION_PRIVMSG;
+	uint64_t now = nowMicros();
+	int channel = bot.channels[state.random() % bot.channels.size()];
+	if (action == ACTION_PRIVMSG)
+	{
+		std::string text = std::to_string(now) + " ";
+		text.resize(config.size, 'x');
+		sendLine(bot, "PRIVMSG " + channelName(channel) + " :" + text);
+	}
+	else if (action == ACTION_JOIN)
+	{
+		int next = 0;
+		while (std::find(bot.channels.begin(), bot.channels.end(), next) != bot.channels.end())
+			next++;
+		bot.channels.push_back(next);
+		sendLine(bot, "JOIN " + channelName(next));
+	}
+	else if (action == ACTION_NICK)
+	{
+		bot.nick = "bot" + std::to_string(bot.id) + "_" + std::to_string(++bot.nickGeneration);
+		sendLine(bot, "NICK " + bot.nick);
+	}
+	else
+		sendLine(bot, "MODE " + channelName(channel));
+	if (action != ACTION_PRIVMSG)
+		bot.pending.push_back({static_cast<benchAction>(action), now});
+	state.sent[action]++;
+}
+
+/*The load phase: with a rate the actions are spread evenly over the time and random bots, without
+  one every bot issues an action whenever the server took all of its previous output.*/
+static void	runLoad(BenchState &state)
+{
+	const BenchConfig &config = state.config;
+	int totalWeight = config.mix[ACTION_PRIVMSG] + config.mix[ACTION_JOIN] + config.mix[ACTION_NICK] + config.mix[ACTION_MODE];
+	uint64_t start = nowMicros();
+	state.loadStart = start;
+	uint64_t end = start + config.duration * 1000000ULL;
+	uint64_t issued = 0;
+
+	for (uint64_t now = start; now < end; now = nowMicros())
+	{
+		if (config.rate == 0)
+		{
+			for (Bot &bot : state.bots)
+			{
+				if (bot.output.empty())
+					issueAction(state, bot, totalWeight);
+			}
+			pollBots(state, 0);
+			continue;
+		}
+		uint64_t due = (now - start) * config.rate / 1000000;
+		for (; issued < due; issued++)
+			issueAction(state, state.bots[state.random() % state.bots.size()], totalWeight);
+		pollBots(state, 1);
+	}
+}
+
+static void	printLatency(const char *name, std::vector<uint32_t> &samples)
+{
+	if (samples.empty())
+		return;
+	std::sort(samples.begin(), samples.end());
+	auto at = [&](double percentile) {
+		return (samples[std::min(samples.size() - 1, static_cast<size_t>(percentile / 100.0 * samples.size()))]);
+	};
+	std::printf("  %-8s %9zu samples  p50 %7u  p90 %7u  p99 %7u  p99.9 %7u  max %7u us\n", name, samples.size(),
+		at(50), at(90), at(99), at(99.9), samples.back());
+}
+
+static void	report(BenchState &state)
+{
+	const BenchConfig &config = state.config;
+	uint64_t actions = 0;
+
+	for (int i = 0; i < ACTION_COUNT; i++)
+		actions += state.sent[i];
+	std::printf("ircbench: %d bots, %d channels, %d s, rate %s\n", config.bots, config.channels, config.duration,
+		config.rate == 0 ? "unlimited" : (std::to_string(config.rate) + "/s").c_str());
+	std::printf("sent      %llu actions (%.0f/s): privmsg %llu join %llu nick %llu mode %llu\n",
+		static_cast<unsigned long long>(actions), static_cast<double>(actions) / config.duration,
+		static_cast<unsigned long long>(state.sent[ACTION_PRIVMSG]), static_cast<unsigned long long>(state.sent[ACTION_JOIN]),
+		static_cast<unsigned long long>(state.sent[ACTION_NICK]), static_cast<unsigned long long>(state.sent[ACTION_MODE]));
+	double seconds = (state.lastInput - state.loadStart) / 1e6;
+	std::printf("delivered %llu PRIVMSG lines (%.0f/s until the last one arrived), %llu error replies, %d bots disconnected\n",
+		static_cast<unsigned long long>(state.delivered), state.delivered / std::max(seconds, 1e-3),
+		static_cast<unsigned long long>(state.errors), state.closedBots);
+	std::printf("latency (PRIVMSG: send to delivery, others: send to reply)\n");
+	for (int i = 0; i < ACTION_COUNT; i++)
+		printLatency(actionNames[i], state.latencies[i]);
+}
+
+int	main(int argc, char **argv)
+{
+	BenchState state;
+
+	if (!parseArguments(argc, argv, state.config))
+	{
+		std::cerr << "Usage: ./ircbench --port=N --password=PASS [--bots=N] [--channels=N] [--duration=SECONDS]"
+			<< std::endl << "       [--rate=ACTIONS_PER_SECOND|0] [--size=BYTES] [--mix=privmsg:90,join:4,nick:3,mode:3]"
+			<< std::endl;
+		return (1);
+	}
+	raiseFdLimit();
+	state.epollFd = epoll_create1(EPOLL_CLOEXEC);
+	state.bots.resize(state.config.bots);
+	for (int i = 0; i < state.config.bots; i++)
+	{
+		state.bots[i].id = i;
+		if (!connectBot(state, state.bots[i]))
+			return (1);
+		pollBots(state, 0);
+	}
+	if (!waitFor(state, SETUP_TIMEOUT_MS, [&] { return (state.registeredBots == state.config.bots); }))
+	{
+		std::cerr << "only " << state.registeredBots << " of " << state.config.bots << " bots registered" << std::endl;
+		return (1);
+	}
+	for (Bot &bot : state.bots)
+	{
+		bot.channels.push_back(bot.id % state.config.channels);
+		sendLine(bot, "JOIN " + channelName(bot.channels[0]));
+	}
+	if (!waitFor(state, SETUP_TIMEOUT_MS, [&] { return (state.joinedBots == state.config.bots); }))
+	{
+		std::cerr << "only " << state.joinedBots << " of " << state.config.bots << " bots joined" << std::endl;
+		return (1);
+	}
+	runLoad(state);
+	waitFor(state, DRAIN_MAX_MS, [&] { return (nowMicros() - state.lastInput > DRAIN_IDLE_MS * 1000ULL); });
+	report(state);
+	for (Bot &bot : state.bots)
+		close(bot.fd);
+	close(state.epollFd);
+	return (0);
+}
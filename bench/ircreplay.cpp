@@ -0,0 +1,551 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+/*
+	Replays a capture of ircserv --capture=FILE against a server on localhost. Every captured
+	connection gets a connection of its own, its lines are sent at their captured times scaled by
+	--speed (2 = twice as fast), or with --speed=0 as fast as the server handles them: after every
+	BARRIER_RECORDS lines a connection sends a PING barrier, and while BARRIER_WINDOW of them are
+	unanswered it gets no further lines. A PONG means the server handled the lines before it and
+	its replies were read, so the server is at most a window of lines behind. Meanwhile the other
+	connections go on with their own lines. Captured PASS lines
+	carry no password, the one given with --password is sent instead.
+
+	Reported are the lines sent per second, what came back, how far the replay fell behind the
+	schedule and the latency of the server under that load: every registered connection sends a
+	PING probe every --probe-interval milliseconds (0 disables them), the time until its PONG is
+	recorded. Connections the server closed before their captured disconnect are reported on their
+	own, the lines they did not get are not counted as sent. All connections run on one epoll loop.
+
+	./ircreplay --port=6667 --password=pw --capture=FILE [--speed=1] [--probe-interval=100]
+*/
+
+#include "TrafficCapture.hpp"
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+const int		EPOLL_BATCH = 256;
+const size_t	DISPATCH_BATCH = 1024;			// records sent between two polls
+const size_t	DISPATCH_LOOKAHEAD = 8192;		// --speed=0: records looked at past a waiting connection
+const int		DRAIN_IDLE_MS = 500;			// the run ends once nothing arrived for this long
+const int		DRAIN_MAX_MS = 30000;
+const size_t	OUTPUT_LIMIT = 64 * 1024;		// the replay waits while a connection is this far behind
+const size_t	BARRIER_RECORDS = 32;			// --speed=0: lines per connection between two barriers
+const int		BARRIER_WINDOW = 4;				// barriers a connection may have in flight
+const char		PROBE_TOKEN[] = "ircreplay-probe";
+const char		BARRIER_TOKEN[] = "ircreplay-barrier";
+
+struct ReplayConfig
+{
+	int			port = 6667;
+	std::string	password;
+	std::string	capture;
+	int			speed = 1;				// 0 for as fast as possible
+	int			probeInterval = 100;	// milliseconds, 0 disables the probes
+};
+
+struct Connection
+{
+	int			fd = -1;
+	std::string	input;
+	std::string	output;
+	bool		registered = false;
+	bool		closed = false;
+	bool		finishing = false;		// captured DISCONNECT: half-closed once the output is written
+	bool		halfClosed = false;
+	bool		quitSent = false;		// the server closes the connection after QUIT
+	uint64_t	probeSentAt = 0;		// 0 while no probe is pending
+	uint64_t	lastProbe = 0;
+	size_t		sinceBarrier = 0;		// lines sent since the last barrier
+	int			barriersPending = 0;
+};
+
+struct ReplayState
+{
+	ReplayConfig				config;
+	int							epollFd = -1;
+	std::vector<CaptureRecord>	records;
+	std::vector<Connection>		connections;
+	std::unordered_map<uint64_t, uint32_t>	byId;		// captured session id to connection
+	std::unordered_set<uint64_t>	waiting;			// sessions passed over by dispatchUnpaced
+	std::vector<uint32_t>		probeLatencies;
+	std::vector<uint32_t>		lag;					// per record, how late it was sent
+	uint64_t					linesSent = 0;
+	uint64_t					bytesSent = 0;
+	uint64_t					linesReceived = 0;
+	uint64_t					bytesReceived = 0;
+	uint64_t					errors = 0;
+	uint64_t					closedByServer = 0;
+	uint64_t					linesDropped = 0;		// records of connections the server closed
+	uint64_t					replayStart = 0;
+	uint64_t					replayEnd = 0;
+	uint64_t					lastInput = 0;
+};
+
+static uint64_t	nowMicros()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000);
+}
+
+static bool	parseInt(const std::string &value, int min, int &result)
+{
+	char *end;
+	long number = std::strtol(value.c_str(), &end, 10);
+
+	if (value.empty() || *end != '\0' || number < min || number > 1000000)
+		return (false);
+	result = static_cast<int>(number);
+	return (true);
+}
+
+static bool	parseArguments(int argc, char **argv, ReplayConfig &config)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+		size_t eq = arg.find('=');
+		if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos)
+			return (false);
+		std::string key = arg.substr(2, eq - 2);
+		std::string value = arg.substr(eq + 1);
+		bool ok = (key == "port" && parseInt(value, 1, config.port))
+			|| (key == "speed" && parseInt(value, 0, config.speed))
+			|| (key == "probe-interval" && parseInt(value, 0, config.probeInterval));
+		if (key == "password" || key == "capture")
+		{
+			(key == "password" ? config.password : config.capture) = value;
+			ok = !value.empty();
+		}
+		if (!ok)
+			return (false);
+	}
+	return (!config.password.empty() && !config.capture.empty());
+}
+
+/*Raises the fd limit to the hard limit, every captured connection needs a socket*/
+static void	raiseFdLimit()
+{
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+static void	closeConnection(Connection &connection)
+{
+	if (connection.closed)
+		return;
+	connection.closed = true;
+	close(connection.fd);
+}
+
+/*Writes what the socket takes, the rest stays in the output buffer. A finishing connection is
+  half-closed once everything was written, the server then handles the lines before it sees the
+  end of the stream and closes the connection.*/
+static void	flushConnection(ReplayState &state, Connection &connection)
+{
+	while (!connection.output.empty() && !connection.closed)
+	{
+		ssize_t bytes = write(connection.fd, connection.output.data(), connection.output.size());
+		if (bytes == -1 && (errno == EAGAIN || errno == EINTR))
+			return;
+		if (bytes <= 0)
+		{
+			state.closedByServer++;
+			closeConnection(connection);
+			return;
+		}
+		connection.output.erase(0, bytes);
+	}
+	if (connection.finishing && connection.output.empty() && !connection.closed)
+	{
+		shutdown(connection.fd, SHUT_WR);
+		connection.finishing = false;
+		connection.halfClosed = true;
+	}
+}
+
+/*Opens the connection of a captured session. A failed connect leaves it closed, its lines are
+  dropped.*/
+static Connection	&openConnection(ReplayState &state, uint64_t id)
+{
+	sockaddr_in addr = {};
+	int one = 1;
+	uint32_t index = state.connections.size();
+
+	state.connections.emplace_back();
+	state.byId[id] = index;
+	Connection &connection = state.connections.back();
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(state.config.port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	connection.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (connection.fd == -1 || connect(connection.fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+	{
+		perror("connect");
+		connection.closed = true;
+		if (connection.fd != -1)
+			close(connection.fd);
+		return (connection);
+	}
+	setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	fcntl(connection.fd, F_SETFL, O_NONBLOCK);
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.u32 = index;
+	epoll_ctl(state.epollFd, EPOLL_CTL_ADD, connection.fd, &ev);
+	return (connection);
+}
+
+/*The connection of a captured session, opened on its first record. A session which connected again
+  after a DISCONNECT (the ids are never reused by the server) gets a new one.*/
+static Connection	&getConnection(ReplayState &state, uint64_t id)
+{
+	auto it = state.byId.find(id);
+
+	if (it == state.byId.end())
+		return (openConnection(state, id));
+	return (state.connections[it->second]);
+}
+
+static void	sendLine(ReplayState &state, Connection &connection, const std::string &line)
+{
+	connection.output += line;
+	connection.output += "\r\n";
+	state.linesSent++;
+	state.bytesSent += line.size() + 2;
+}
+
+/*Captured PASS lines had their parameter replaced by "*"*/
+static bool	isRedactedPass(const std::string &line)
+{
+	return (line.size() == 6 && strncasecmp(line.c_str(), "PASS *", 6) == 0);
+}
+
+static void	replayRecord(ReplayState &state, const CaptureRecord &record)
+{
+	if (record.type == CAPTURE_CONNECT)
+	{
+		getConnection(state, record.connection);
+		return;
+	}
+	Connection &connection = getConnection(state, record.connection);
+	if (connection.closed)
+	{
+		if (record.type == CAPTURE_LINE)
+			state.linesDropped++;
+		return;
+	}
+	if (record.type == CAPTURE_DISCONNECT)
+	{
+		connection.finishing = true;
+		flushConnection(state, connection);
+		state.byId.erase(record.connection);
+	}
+	else if (isRedactedPass(record.line))
+		sendLine(state, connection, "PASS " + state.config.password);
+	else
+	{
+		sendLine(state, connection, record.line);
+		if (strncasecmp(record.line.c_str(), "QUIT", 4) == 0 && (record.line.size() == 4 || record.line[4] == ' '))
+			connection.quitSent = true;
+	}
+	if (record.type == CAPTURE_LINE && state.config.speed == 0 && ++connection.sinceBarrier >= BARRIER_RECORDS)
+	{
+		connection.output += std::string("PING :") + BARRIER_TOKEN + "\r\n";
+		connection.barriersPending++;
+		connection.sinceBarrier = 0;
+	}
+}
+
+static void	handleLine(ReplayState &state, Connection &connection, std::string_view line, uint64_t now)
+{
+	size_t space = line.find(' ');
+	std::string_view first = line.substr(0, space);
+	std::string_view rest = (space == std::string_view::npos) ? std::string_view() : line.substr(space + 1);
+
+	state.linesReceived++;
+	if (!first.empty() && first[0] == ':')
+	{
+		space = rest.find(' ');
+		first = rest.substr(0, space);
+		rest = (space == std::string_view::npos) ? std::string_view() : rest.substr(space + 1);
+	}
+	if (first == "001")
+		connection.registered = true;
+	else if (first == "PONG" && connection.barriersPending > 0 && rest.find(BARRIER_TOKEN) != std::string_view::npos)
+		connection.barriersPending--;
+	else if (first == "PONG" && connection.probeSentAt != 0 && rest.find(PROBE_TOKEN) != std::string_view::npos)
+	{
+		state.probeLatencies.push_back(static_cast<uint32_t>(now - connection.probeSentAt));
+		connection.probeSentAt = 0;
+	}
+	else if (first.size() == 3 && first[0] == '4')
+		state.errors++;
+}
+
+static void	readConnection(ReplayState &state, Connection &connection, uint64_t now)
+{
+	char buffer[16384];
+
+	while (!connection.closed)
+	{
+		ssize_t bytes = read(connection.fd, buffer, sizeof(buffer));
+		if (bytes == -1 && (errno == EAGAIN || errno == EINTR))
+			break;
+		if (bytes <= 0)
+		{
+			if (bytes == -1 || !(connection.halfClosed || connection.quitSent))
+				state.closedByServer++;
+			closeConnection(connection);
+			break;
+		}
+		connection.input.append(buffer, bytes);
+		state.bytesReceived += bytes;
+		state.lastInput = now;
+	}
+	size_t start = 0;
+	size_t end;
+	while ((end = connection.input.find("\r\n", start)) != std::string::npos)
+	{
+		handleLine(state, connection, std::string_view(connection.input).substr(start, end - start), now);
+		start = end + 2;
+	}
+	connection.input.erase(0, start);
+}
+
+/*Sends a PING probe on every registered connection whose last probe was answered and is older
+  than the probe interval*/
+static void	sendProbes(ReplayState &state, uint64_t now)
+{
+	uint64_t interval = state.config.probeInterval * 1000ULL;
+
+	if (interval == 0)
+		return;
+	for (Connection &connection : state.connections)
+	{
+		if (connection.closed || connection.halfClosed || connection.finishing || !connection.registered
+			|| connection.probeSentAt != 0
+			|| now - connection.lastProbe < interval)
+			continue;
+		connection.output += std::string("PING :") + PROBE_TOKEN + "\r\n";
+		connection.probeSentAt = now;
+		connection.lastProbe = now;
+	}
+}
+
+/*Handles the readable connections and writes their pending output, waiting at most timeoutMs*/
+static void	pollConnections(ReplayState &state, int timeoutMs)
+{
+	struct epoll_event events[EPOLL_BATCH];
+
+	int ready = epoll_wait(state.epollFd, events, EPOLL_BATCH, timeoutMs);
+	uint64_t now = nowMicros();
+	for (int i = 0; i < ready; i++)
+		readConnection(state, state.connections[events[i].data.u32], now);
+	sendProbes(state, now);
+	for (Connection &connection : state.connections)
+		flushConnection(state, connection);
+}
+
+/*True while the connection of the captured session may not get further lines: it is OUTPUT_LIMIT
+  bytes behind or waits for its barriers*/
+static bool	mustWait(const ReplayState &state, uint64_t id)
+{
+	auto it = state.byId.find(id);
+
+	if (it == state.byId.end())
+		return (false);
+	const Connection &connection = state.connections[it->second];
+	return (!connection.closed && (connection.output.size() > OUTPUT_LIMIT
+		|| connection.barriersPending >= BARRIER_WINDOW));
+}
+
+/*Sends the records which are due, in capture order. A connection which has to wait holds up the
+  replay, the lag of every record is recorded.*/
+static size_t	dispatchDue(ReplayState &state, size_t &next, uint64_t now)
+{
+	size_t sent = 0;
+
+	while (next < state.records.size() && sent < DISPATCH_BATCH)
+	{
+		const CaptureRecord &record = state.records[next];
+		uint64_t due = state.replayStart + record.time / state.config.speed;
+		if (due > now || mustWait(state, record.connection))
+			break;
+		replayRecord(state, record);
+		state.lag.push_back(static_cast<uint32_t>(now - due));
+		next++;
+		sent++;
+	}
+	return (sent);
+}
+
+/*--speed=0: sends what the connections may take from the next DISPATCH_LOOKAHEAD records. The
+  records of a connection which has to wait are passed over, so one connection the server is slow
+  to answer does not hold up the others. Every connection keeps the order of its own records:
+  once one of its records was passed over, its later ones are passed over too.*/
+static size_t	dispatchUnpaced(ReplayState &state, size_t &next, std::vector<bool> &done)
+{
+	size_t end = std::min(state.records.size(), next + DISPATCH_LOOKAHEAD);
+	size_t sent = 0;
+
+	state.waiting.clear();
+	for (size_t i = next; i < end && sent < DISPATCH_BATCH; i++)
+	{
+		if (done[i])
+			continue;
+		const CaptureRecord &record = state.records[i];
+		if (state.waiting.count(record.connection) != 0 || mustWait(state, record.connection))
+		{
+			state.waiting.insert(record.connection);
+			continue;
+		}
+		replayRecord(state, record);
+		done[i] = true;
+		sent++;
+	}
+	while (next < state.records.size() && done[next])
+		next++;
+	return (sent);
+}
+
+/*Sends the records when they are due (or as fast as the server handles them with --speed=0), the
+  replay ends once the server took everything*/
+static void	runReplay(ReplayState &state)
+{
+	const int			speed = state.config.speed;
+	size_t				next = 0;
+	std::vector<bool>	done(speed == 0 ? state.records.size() : 0);
+
+	state.replayStart = nowMicros();
+	while (next < state.records.size())
+	{
+		uint64_t now = nowMicros();
+		size_t sent = (speed == 0) ? dispatchUnpaced(state, next, done) : dispatchDue(state, next, now);
+		int timeout = 0;
+		if (sent == 0 && next < state.records.size())
+		{
+			uint64_t due = state.replayStart + (speed == 0 ? 0 : state.records[next].time / speed);
+			timeout = (due > now) ? static_cast<int>(std::min<uint64_t>((due - now + 999) / 1000, 10)) : 1;
+		}
+		pollConnections(state, timeout);
+	}
+	uint64_t deadline = nowMicros() + DRAIN_MAX_MS * 1000ULL;
+	auto written = [&state]() {
+		for (const Connection &connection : state.connections)
+		{
+			if (!connection.closed && (!connection.output.empty() || connection.finishing))
+				return (false);
+		}
+		return (true);
+	};
+	while (!written() && nowMicros() < deadline)
+		pollConnections(state, 1);
+	state.replayEnd = nowMicros();
+}
+
+static void	printLatency(const char *name, std::vector<uint32_t> &samples)
+{
+	if (samples.empty())
+		return;
+	std::sort(samples.begin(), samples.end());
+	auto at = [&](double percentile) {
+		return (samples[std::min(samples.size() - 1, static_cast<size_t>(percentile / 100.0 * samples.size()))]);
+	};
+	std::printf("  %-8s %9zu samples  p50 %7u  p90 %7u  p99 %7u  p99.9 %7u  max %7u us\n", name, samples.size(),
+		at(50), at(90), at(99), at(99.9), samples.back());
+}
+
+static void	report(ReplayState &state)
+{
+	const ReplayConfig &config = state.config;
+	double captured = state.records.empty() ? 0 : state.records.back().time / 1e6;
+	double replayed = std::max((state.replayEnd - state.replayStart) / 1e6, 1e-3);
+	double received = std::max((std::max(state.lastInput, state.replayEnd) - state.replayStart) / 1e6, 1e-3);
+
+	std::printf("ircreplay: %s, %zu records, %zu connections, %.2f s captured, speed %s\n", config.capture.c_str(),
+		state.records.size(), state.connections.size(), captured,
+		config.speed == 0 ? "max" : (std::to_string(config.speed) + "x").c_str());
+	std::printf("sent      %llu lines, %llu bytes in %.2f s (%.0f lines/s, %.2fx the captured rate)\n",
+		static_cast<unsigned long long>(state.linesSent), static_cast<unsigned long long>(state.bytesSent), replayed,
+		state.linesSent / replayed, captured / replayed);
+	std::printf("received  %llu lines, %llu bytes (%.0f lines/s until the last one arrived), %llu error replies\n",
+		static_cast<unsigned long long>(state.linesReceived), static_cast<unsigned long long>(state.bytesReceived),
+		state.linesReceived / received, static_cast<unsigned long long>(state.errors));
+	std::printf("dropped   %llu connections closed by the server, %llu of their captured lines not sent\n",
+		static_cast<unsigned long long>(state.closedByServer), static_cast<unsigned long long>(state.linesDropped));
+	std::printf("latency (probe: PING to PONG, lag: records sent behind their scaled capture time)\n");
+	printLatency("probe", state.probeLatencies);
+	printLatency("lag", state.lag);
+}
+
+int	main(int argc, char **argv)
+{
+	ReplayState		state;
+	CaptureRecord	record;
+
+	if (!parseArguments(argc, argv, state.config))
+	{
+		std::cerr << "Usage: ./ircreplay --port=N --password=PASS --capture=FILE [--speed=N|0]"
+			<< " [--probe-interval=MS]" << std::endl;
+		return (1);
+	}
+	try
+	{
+		CaptureReader reader(state.config.capture);
+		while (reader.next(record))
+			state.records.push_back(record);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+		return (1);
+	}
+	raiseFdLimit();
+	state.epollFd = epoll_create1(EPOLL_CLOEXEC);
+	runReplay(state);
+	uint64_t deadline = nowMicros() + DRAIN_MAX_MS * 1000ULL;
+	while (nowMicros() - std::max(state.lastInput, state.replayEnd) < DRAIN_IDLE_MS * 1000ULL && nowMicros() < deadline)
+		pollConnections(state, 10);
+	report(state);
+	for (Connection &connection : state.connections)
+		closeConnection(connection);
+	close(state.epollFd);
+	return (0);
+}
@@ -0,0 +1,462 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Server.hpp"
+#include "Logger.hpp"
+#include "LoopbackTransport.hpp"
+#include "IrcMessage.hpp"
+#include "CommandTable.hpp"
+#include "SendQueue.hpp"
+#include "response.hpp"
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*Sample of typical client lines, registration and channel traffic*/
+static const std::vector<std::string> sampleLines = {
+	"NICK alice",
+	"USER alice 0 * :Alice Example",
+	"JOIN #chan,#other key",
+	"PRIVMSG #chan :hello everyone, how is it going today?",
+	"PRIVMSG bob :just a private message",
+	"MODE #chan +kl secret 10",
+	"TOPIC #chan :a new topic for the channel",
+	"KICK #chan bob :behave yourself",
+	"INVITE bob #chan",
+	"PING :irc.example.net",
+};
+
+/*Line handling as it was done before IrcMessage: the registration path split the line with a
+  regex, the command path and the handlers tokenized it again with istringstream.*/
+static std::vector<std::string>	legacySplitString(const std::string &str)
+{
+	std::vector<std::string> tokens;
+	std::regex re("\\s+");
+	std::sregex_token_iterator it(str.begin(), str.end(), re, -1);
+	std::sregex_token_iterator end;
+
+	while (it != end)
+	{
+		if (!it->str().empty())
+			tokens.push_back(*it);
+		++it;
+	}
+	return tokens;
+}
+
+static size_t	legacyParse(const std::string &line)
+{
+	std::string args[3];
+	std::istringstream iss(line);
+	iss >> args[0] >> args[1];
+	std::getline(iss, args[2]);
+	return (args[0].size() + args[1].size() + args[2].size());
+}
+
+/*Heap allocations of the whole program, counted by the replaced global operator new*/
+static std::atomic<size_t>	allocations(0);
+
+void	*operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *memory = std::malloc(size != 0 ? size : 1))
+		return (memory);
+	throw std::bad_alloc();
+}
+
+/*Kept out of line: inlined at -O2, GCC pairs the free with the new expression and rejects it*/
+__attribute__((noinline)) void	operator delete(void *memory) noexcept { std::free(memory); }
+
+__attribute__((noinline)) void	operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+/*One measured case as written to the result file*/
+struct BenchResult
+{
+	std::string	name;
+	size_t		entries;		// size of the index or channel, 0 if the case has none
+	long		operations;
+	double		nsPerOp;
+	double		allocsPerOp;
+	size_t		checksum;
+};
+
+static std::vector<BenchResult>	results;
+
+/*Calls func(i) operations times and records the mean time and heap allocations per call. The
+  checksum summed from the return values keeps the compiler from optimizing the work away.*/
+template <typename Func>
+static void	measure(const std::string &name, size_t entries, long operations, Func func)
+{
+	size_t sink = 0;
+	size_t allocated = allocations.load(std::memory_order_relaxed);
+	auto start = std::chrono::steady_clock::now();
+	for (long i = 0; i < operations; i++)
+		sink += func(i);
+	auto end = std::chrono::steady_clock::now();
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / operations;
+	double allocs = static_cast<double>(allocations.load(std::memory_order_relaxed) - allocated) / operations;
+	results.push_back({name, entries, operations, ns, allocs, sink});
+	std::cout << name;
+	if (entries != 0)
+		std::cout << " (" << entries << " entries)";
+	std::cout << ": " << ns << " ns/op, " << allocs << " allocs/op (checksum " << sink << ")" << std::endl;
+}
+
+/*Runs func over the sample lines, one operation per line*/
+template <typename Func>
+static void	runCase(const std::string &name, int iterations, Func func)
+{
+	measure(name, 0, static_cast<long>(iterations) * sampleLines.size(), [&](long i) {
+		return func(sampleLines[i % sampleLines.size()]);
+	});
+}
+
+/*Channel fan-out: queue one PRIVMSG for every member of a channel, either formatting the line
+  per recipient or formatting it once and sharing the buffer between all member queues.*/
+template <typename Func>
+static void	runFanout(const std::string &name, int members, int rounds, Func func)
+{
+	std::vector<SendQueue> queues(members);
+
+	measure(name, members, rounds, [&](long) {
+		size_t bytes = 0;
+		func(queues);
+		for (SendQueue &queue : queues)
+		{
+			bytes += queue.getBytes();
+			queue.clear();
+		}
+		return bytes;
+	});
+}
+
+/*Nick and channel index lookups, hits and misses. The nick index only stores pointers, so every
+  entry points to the same client: its nick is reset before registering the next one, which keeps
+  registerNick from removing the previous entry.*/
+static void	benchLookups(size_t entries, long operations)
+{
+	Server						server;
+	Client						client;
+	std::vector<std::string>	nicks, missingNicks, channels, missingChannels;
+
+	for (size_t i = 0; i < entries; i++)
+	{
+		nicks.push_back("Nick" + std::to_string(i));
+		missingNicks.push_back("Gone" + std::to_string(i));
+		channels.push_back("#Chan" + std::to_string(i));
+		missingChannels.push_back("#Gone" + std::to_string(i));
+		client.setNick("");
+		server.registerNick(client, nicks.back());
+		server.createChannel(channels.back());
+	}
+	// a stride through the names instead of their order, so consecutive lookups hit other buckets
+	auto pick = [entries](long i) { return (static_cast<size_t>(i) * 7919) % entries; };
+	measure("getClientByNickname hit", entries, operations, [&](long i) {
+		return static_cast<size_t>(server.getClientByNickname(nicks[pick(i)]) != nullptr);
+	});
+	measure("getClientByNickname miss", entries, operations, [&](long i) {
+		return static_cast<size_t>(server.getClientByNickname(missingNicks[pick(i)]) != nullptr);
+	});
+	measure("getChannelByChannelName hit", entries, operations, [&](long i) {
+		return static_cast<size_t>(server.getChannelByChannelName(channels[pick(i)]) != nullptr);
+	});
+	measure("getChannelByChannelName miss", entries, operations, [&](long i) {
+		return static_cast<size_t>(server.getChannelByChannelName(missingChannels[pick(i)]) != nullptr);
+	});
+	for (auto &entry : server.getChannels())
+		delete entry.second;
+}
+
+/*Lines a simulated client sends to register*/
+static std::string	registrationLines(const std::string &nick)
+{
+	return ("CAP LS 302\r\nPASS bench\r\nNICK " + nick + "\r\nUSER " + nick + " 0 * :" + nick + "\r\nCAP END\r\n");
+}
+
+/*Lines passed through Server::handleClientMessage by a registered member of a channel, including
+  the handlers and queueing the replies. The clients are simulated by a loopback transport, their
+  queued replies are dropped every few lines.*/
+static void	benchDispatch(long operations)
+{
+	const size_t		members = 10;
+	Server				server(6667, "bench");
+	LoopbackTransport	transport(server);
+	std::vector<Client *>	clients;
+
+	for (size_t i = 0; i < members; i++)
+	{
+		clients.push_back(transport.connect());
+		transport.receive(*clients.back(), registrationLines("user" + std::to_string(i)) + "JOIN #bench\r\n");
+	}
+	transport.receive(*clients[0], "TOPIC #bench :benchmark channel\r\n");
+	static const std::vector<std::string> lines = {
+		"PING :irc.example.net",
+		"PRIVMSG user1 :just a private message",
+		"PRIVMSG #bench :hello everyone, how is it going today?",
+		"MODE #bench",
+		"MODE #bench +l 20",
+		"TOPIC #bench",
+		"UNKNOWN command",
+	};
+	for (const std::string &line : lines)
+	{
+		measure("handleClientMessage " + line.substr(0, line.find(" :")), members, operations, [&](long i) {
+			server.handleClientMessage(*clients[0], line);
+			if (i % 256 != 255)
+				return (static_cast<size_t>(0));
+			size_t bytes = 0;
+			for (Client *client : clients)
+			{
+				bytes += client->getSendQueue().getBytes();
+				client->getSendQueue().clear();
+			}
+			return (bytes);
+		});
+	}
+}
+
+/*Whole sessions of simulated clients through the loopback transport, from framing the input to
+  the replies taken from the send queues: registration and JOIN into one of ten channels, channel
+  messages (the queues are emptied once per round over all clients), NICK of clients sharing
+  several channels and QUIT, which closes the connection.*/
+static void	benchLoopback(size_t sessions, long operations)
+{
+	ServerConfig			config;
+	std::vector<Client *>	clients(sessions);
+	std::string				output;
+
+	config.maxClients = sessions;
+	Server server(6667, "bench");
+	server.setConfig(config);
+	LoopbackTransport transport(server);
+	auto drain = [&]() {
+		size_t bytes = 0;
+		for (Client *client : clients)
+			bytes += transport.takeOutput(*client, output);
+		output.clear();
+		return (bytes);
+	};
+	measure("loopback register + JOIN", sessions, sessions, [&](long i) {
+		clients[i] = transport.connect();
+		transport.receive(*clients[i], registrationLines("sim" + std::to_string(i))
+			+ "JOIN #sim" + std::to_string(i % 10) + "\r\n");
+		return (transport.takeOutput(*clients[i], output));
+	});
+	drain();
+	measure("loopback channel PRIVMSG", sessions, operations, [&](long i) {
+		size_t sender = static_cast<size_t>(i) % sessions;
+		transport.receive(*clients[sender], "PRIVMSG #sim" + std::to_string(sender % 10)
+			+ " :hello everyone, how is it going today?\r\n");
+		return (sender == sessions - 1 ? drain() : 0);
+	});
+	drain();
+	// the first 50 clients share five channels, each of them has to be told about a NICK once
+	const size_t sharing = std::min<size_t>(50, sessions);
+	for (size_t i = 0; i < sharing; i++)
+		transport.receive(*clients[i], "JOIN #sim0,#sim1,#sim2,#sim3,#sim4\r\n");
+	drain();
+	measure("loopback NICK, 5 shared channels", sessions, operations, [&](long i) {
+		size_t renamed = static_cast<size_t>(i) % sharing;
+		transport.receive(*clients[renamed], "NICK n" + std::to_string(i) + "\r\n");
+		return (renamed == sharing - 1 ? drain() : 0);
+	});
+	drain();
+	measure("loopback QUIT", sessions, sessions, [&](long i) {
+		transport.receive(*clients[i], "QUIT :bye\r\n");
+		size_t bytes = transport.takeOutput(*clients[i], output);
+		transport.step();
+		return (bytes);
+	});
+}
+
+/*Mode string and names list of a channel with every mode set and 100 members, cached and rendered
+  again after a change, and the compression of the applied modes into sign groups as done for the
+  MODE reply*/
+static void	benchModes(long operations)
+{
+	Server				server;
+	std::vector<Client>	members(100);
+	Channel				channel("#bench");
+
+	channel.setInviteOnlyState(true);
+	channel.setChannelPassw("secret");
+	channel.setUserLimit(42);
+	channel.setTopicOperatorsOnlyState(true);
+	for (size_t i = 0; i < members.size(); i++)
+	{
+		members[i].setNick("member" + std::to_string(i));
+		channel.addClient(&members[i]);
+	}
+	channel.setChOperator(&members[0]);
+	measure("Channel::getMode", 0, operations, [&](long) {
+		return channel.getMode().size();
+	});
+	measure("Channel::getMode after a change", 0, operations, [&](long) {
+		channel.bumpVersion();
+		return channel.getMode().size();
+	});
+	measure("Channel::getNamesChunks", members.size(), operations, [&](long) {
+		return channel.getNamesChunks().size();
+	});
+	measure("Channel::getNamesChunks after a change", members.size(), operations / 10, [&](long) {
+		channel.bumpVersion();
+		return channel.getNamesChunks().size();
+	});
+	measure("Server::compressModes", 0, operations, [&](long) {
+		return server.compressModes("+i+k+l-t-o+o").size();
+	});
+}
+
+/*Replies as they were built before Reply: the macros chained std::string operator+ and the
+  line was copied once more to append \r\n before it was shared with the send queues.*/
+static SharedLine	legacyLine(const std::string &message)
+{
+	return (std::make_shared<const std::string>(message + "\r\n"));
+}
+
+/*Reply macros of response.hpp up to the SharedLine which is queued, compared with the operator+
+  chains they replaced. The relayed PRIVMSG starts with the sender's cached prefix, the chain
+  renders nick!user@host for every message.*/
+static void	benchReplies(long operations)
+{
+	const std::string nick = "alice", target = "bob", channel = "#chan", text = "hello everyone, how is it going today?";
+	const std::string users = "alice bob carol dave erin frank grace heidi ivan judy";
+	const std::string modes = "+iklt secret 42";
+	Client sender;
+
+	sender.setNick(nick);
+	sender.setUsername(nick);
+	measure("RPL_PRIVMSG, operator+ chain", 0, operations, [&](long) {
+		return legacyLine(":" + sender.getNick() + "!" + sender.getUsername() + "@" + sender.getHost()
+			+ " PRIVMSG " + channel + " :" + text)->size();
+	});
+	measure("RPL_PRIVMSG", 0, operations, [&](long) {
+		return RPL_PRIVMSG(sender.getPrefix(), channel, text).line()->size();
+	});
+	measure("RPL_NAMREPLY, operator+ chain", 0, operations, [&](long) {
+		return legacyLine(":" + std::string(SERVER_NAME) + " 353 " + nick + " @ " + channel + " :" + users)->size();
+	});
+	measure("RPL_NAMREPLY", 0, operations, [&](long) {
+		return RPL_NAMREPLY(nick, channel, users).line()->size();
+	});
+	measure("RPL_CHANNELMODEIS, operator+ chain", 0, operations, [&](long) {
+		return legacyLine(":" + std::string(SERVER_NAME) + " 324 " + nick + " " + channel + " " + modes)->size();
+	});
+	measure("RPL_CHANNELMODEIS", 0, operations, [&](long) {
+		return RPL_CHANNELMODEIS(nick, channel, modes).line()->size();
+	});
+	measure("ERR_NOSUCHNICK, operator+ chain", 0, operations, [&](long) {
+		return legacyLine(":" + std::string(SERVER_NAME) + " 401 " + nick + " " + target + " :No such nick/channel")->size();
+	});
+	measure("ERR_NOSUCHNICK", 0, operations, [&](long) {
+		return ERR_NOSUCHNICK(nick, target).line()->size();
+	});
+}
+
+/*Writes the results as JSON, one object per case*/
+static bool	writeResults(const std::string &path)
+{
+	std::ofstream out(path);
+
+	if (!out)
+		return (false);
+	out << "{\n\t\"unit\": \"ns/op\",\n\t\"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult &result = results[i];
+		out << "\t\t{\"name\": \"" << result.name << "\", \"entries\": " << result.entries
+			<< ", \"operations\": " << result.operations << ", \"ns_per_op\": " << result.nsPerOp
+			<< ", \"allocs_per_op\": " << result.allocsPerOp
+			<< ", \"checksum\": " << result.checksum << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "\t]\n}\n";
+	return (static_cast<bool>(out));
+}
+
+int	main(int argc, char **argv)
+{
+	int			iterations = 20000;
+	std::string	outPath = "microbench.json";
+
+	// the sessions would log every connect and command, keep that out of the timings
+	Logger::configure("all:warn");
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg.rfind("--iterations=", 0) == 0)
+			iterations = std::stoi(arg.substr(13));
+		else if (arg.rfind("--out=", 0) == 0)
+			outPath = arg.substr(6);
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--iterations=N] [--out=FILE]" << std::endl;
+			return (1);
+		}
+	}
+	if (iterations <= 0)
+	{
+		std::cerr << "--iterations must be positive" << std::endl;
+		return (1);
+	}
+	long operations = static_cast<long>(iterations) * 10;
+
+	runCase("legacy SplitString (regex)", iterations / 10 + 1, [](const std::string &line) {
+		return legacySplitString(line).size();
+	});
+	runCase("legacy istringstream", iterations, [](const std::string &line) {
+		return legacyParse(line);
+	});
+	runCase("parseIrcMessage", iterations, [](const std::string &line) {
+		IrcMessage msg;
+		parseIrcMessage(line, msg);
+		return static_cast<size_t>(msg.paramCount) + msg.command.size();
+	});
+	runCase("parseIrcMessage + findCommand", iterations, [](const std::string &line) {
+		IrcMessage msg;
+		parseIrcMessage(line, msg);
+		const CommandEntry *command = findCommand(msg.command);
+		return static_cast<size_t>(command ? command->minParams : 0);
+	});
+	benchDispatch(operations / 10);
+	benchLoopback(1000, operations / 10);
+	for (size_t entries : {10, 1000, 100000})
+		benchLookups(entries, operations);
+	benchModes(operations);
+	benchReplies(operations);
+	const std::string prefix = ":alice!alice@127.0.0.1", channel = "#chan", text = "hello everyone, how is it going today?";
+	int rounds = iterations / 100 + 1;
+	runFanout("fan-out, line per recipient", 5000, rounds, [&](std::vector<SendQueue> &queues) {
+		for (SendQueue &queue : queues)
+			queue.push(RPL_PRIVMSG(prefix, channel, text).line());
+	});
+	runFanout("fan-out, shared line", 5000, rounds, [&](std::vector<SendQueue> &queues) {
+		SharedLine line = RPL_PRIVMSG(prefix, channel, text).line();
+		for (SendQueue &queue : queues)
+			queue.push(line);
+	});
+	if (!writeResults(outPath))
+	{
+		std::cerr << "Could not write " << outPath << std::endl;
+		return (1);
+	}
+	std::cout << "Results written to " << outPath << std::endl;
+	return (0);
+}
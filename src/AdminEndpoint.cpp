@@ -0,0 +1,134 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "AdminEndpoint.hpp"
+#include "Server.hpp"
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+/* ************************************************Constructor Section START*************************************** */
+AdminEndpoint::AdminEndpoint(Server &server, int port) : _server(server), _listenFd(-1), _wakeFd(-1)
+{
+	int opt = 1;
+	sockaddr_in addr = {};
+
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (_listenFd == -1)
+		throw std::system_error(errno, std::generic_category(), "Admin socket creation failed");
+	setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	if (bind(_listenFd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(_listenFd, 16) == -1)
+	{
+		int error = errno;
+		close(_listenFd);
+		throw std::system_error(error, std::generic_category(), "Admin endpoint bind failed");
+	}
+	_wakeFd = eventfd(0, EFD_CLOEXEC);
+	if (_wakeFd == -1)
+	{
+		int error = errno;
+		close(_listenFd);
+		throw std::system_error(error, std::generic_category(), "eventfd failed");
+	}
+}
+
+AdminEndpoint::~AdminEndpoint()
+{
+	stop();
+	close(_wakeFd);
+	close(_listenFd);
+}
+
+/* ************************************************Constructor Section END*************************************** */
+
+void	AdminEndpoint::start() { _thread = std::thread(&AdminEndpoint::run, this); }
+
+void	AdminEndpoint::stop()
+{
+	uint64_t value = 1;
+
+	if (!_thread.joinable())
+		return;
+	if (write(_wakeFd, &value, sizeof(value)) == -1)
+		LOG(LEVEL_ERROR, LOG_CORE, "eventfd write failed: " << std::strerror(errno));
+	_thread.join();
+}
+
+/*Waits for connections until stop() signals the wake fd*/
+void	AdminEndpoint::run()
+{
+	struct pollfd fds[2] = {{_listenFd, POLLIN, 0}, {_wakeFd, POLLIN, 0}};
+
+	while (true)
+	{
+		if (poll(fds, 2, -1) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			LOG(LEVEL_ERROR, LOG_CORE, "Admin endpoint poll failed: " << std::strerror(errno));
+			return;
+		}
+		if (fds[1].revents != 0)
+			return;
+		int fd = accept4(_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+		if (fd == -1)
+			continue;
+		serve(fd);
+		close(fd);
+	}
+}
+
+/*Reads the request head (bounded in size and time) and answers it. Only GET /metrics is known.*/
+void	AdminEndpoint::serve(int fd)
+{
+	struct timeval	timeout = {ADMIN_TIMEOUT_MS / 1000, (ADMIN_TIMEOUT_MS % 1000) * 1000};
+	char			buffer[ADMIN_REQUEST_MAX];
+	std::string		request;
+	std::string		body;
+	std::string		status = "200 OK";
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	while (request.find("\r\n\r\n") == std::string::npos && request.size() < ADMIN_REQUEST_MAX)
+	{
+		ssize_t bytes = recv(fd, buffer, sizeof(buffer), 0);
+		if (bytes <= 0)
+			return;
+		request.append(buffer, bytes);
+	}
+	if (request.compare(0, 13, "GET /metrics ") == 0)
+		_server.writePrometheus(body);
+	else
+	{
+		status = "404 Not Found";
+		body = "not found\n";
+	}
+	std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\n"
+		"Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+	size_t sent = 0;
+	while (sent < response.size())
+	{
+		ssize_t bytes = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+		if (bytes <= 0)
+			return;
+		sent += bytes;
+	}
+}
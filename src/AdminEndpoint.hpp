@@ -0,0 +1,46 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <string>
+#include <thread>
+
+class Server;
+
+const int	ADMIN_REQUEST_MAX = 4096;
+const int	ADMIN_TIMEOUT_MS = 1000;
+
+/*Local HTTP endpoint for monitoring. Listens on 127.0.0.1 only and answers GET /metrics with the
+  server metrics in the Prometheus text format. It runs on a thread of its own and serves one
+  request at a time with blocking sockets, so a slow scraper never delays an event loop. The
+  metrics it reads are atomic counters.*/
+class AdminEndpoint
+{
+	public:
+		AdminEndpoint(Server &server, int port);
+		AdminEndpoint(const AdminEndpoint &other) = delete;
+		AdminEndpoint &operator=(const AdminEndpoint &other) = delete;
+		~AdminEndpoint();
+
+		void	start();
+		void	stop();
+
+	private:
+		void	run();
+		void	serve(int fd);
+
+		Server				&_server;
+		int					_listenFd;
+		int					_wakeFd;
+		std::thread			_thread;
+};
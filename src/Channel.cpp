@@ -12,16 +12,18 @@
 
 #include "Channel.hpp"
 #include "response.hpp"
+#include "Logger.hpp"
 #include <algorithm>
 #include <chrono>
 
 /* ************************************************Constructor Section START*************************************** */
-Channel::Channel() {}
+Channel::Channel() : _version(1), _modeVersion(0), _namesVersion(0) {}
 
 Channel::Channel(std::string name)
-	: _channelName(name), _channelPassw(""), _userLimit(-1), _topicOperatorsOnly(false), _inviteOnlyEnabled(false) {}
+	: _channelName(name), _channelPassw(""), _userLimit(-1), _topicOperatorsOnly(false), _inviteOnlyEnabled(false),
+	  _version(1), _modeVersion(0), _namesVersion(0) {}
 
-Channel::Channel(const Channel &other)
+Channel::Channel(const Channel &other) : _version(1), _modeVersion(0), _namesVersion(0)
 {
 	this->_channelName = other._channelName;
 	this->_channelPassw = other._channelPassw;
@@ -38,6 +40,7 @@ Channel &Channel::operator=(const Channel &other)
 		this->_userLimit = other._userLimit;
 		this->_topicOperatorsOnly = other._topicOperatorsOnly;
 		this->_inviteOnlyEnabled = other._inviteOnlyEnabled;
+		bumpVersion();
 	}
 	return *this;
 }
@@ -54,7 +57,7 @@ std::string Channel::getChannelPassw() const
 {
 	if (_channelPassw.empty())
 	{
-		std::cout << "No password set for #" << _channelName << std::endl;
+		LOG(LEVEL_DEBUG, LOG_CHANNEL, "No password set for #" << _channelName);
 		return ("");
 	}
 	return (_channelPassw);
@@ -72,25 +75,35 @@ bool Channel::isClientOperator(Client* client) {
 
 /*Checks if passed client is member of channel*/
 bool Channel::isClientInChannel(Client* client) {
-    for (Client* user : _userList) {
-        if (user == client) {
-            return true;
-        }
-    }
-    return false;
+    return (client != nullptr && client->isInChannel(this));
 }
 
 /*Function for setting the password of a channel*/
-void	Channel::setChannelPassw(const std::string& password) { _channelPassw = password; }
+void	Channel::setChannelPassw(const std::string& password)
+{
+	_channelPassw = password;
+	bumpVersion();
+}
+
+/*Version of the channel state, bumped on every change of the members, operators, modes or topic
+  (and by the server when a member changes the nick). The rendered mode string and names list are
+  kept until the version changes.*/
+uint64_t	Channel::getVersion() const { return (_version); }
+
+void	Channel::bumpVersion() { _version++; }
 
-/*Returns a copy of a string with the current active modes of a channel and the respective
-  parameters if applicable. Inserts + sign at beginning of string. If no mode active, only
-  returns string with + sign in it.*/
-std::string	Channel::getMode() const
+/*Returns a string with the current active modes of a channel and the respective parameters if
+  applicable. Inserts + sign at beginning of string. If no mode active, only returns string with
+  + sign in it. The string is rendered once per version of the channel.*/
+const std::string	&Channel::getMode() const
 {
-	std::string	activeModes;
+	if (_modeVersion == _version)
+		return (_modeCache);
+
+	std::string	&activeModes = _modeCache;
 	std::string parameters;
-	
+
+	activeModes.clear();
 	if (_inviteOnlyEnabled)
 		activeModes += 'i';
 	if (!_channelPassw.empty()) {
@@ -112,51 +125,82 @@ std::string	Channel::getMode() const
 	activeModes.insert(0, 1, '+');
 	if (!parameters.empty())
 		activeModes += " " + parameters;
+	_modeVersion = _version;
 	return (activeModes);
 }
 
+/*Returns the members for RPL_NAMREPLY, operators with a leading @, split into space separated
+  chunks which keep every reply (with the server prefix) within MAX_LINE_LENGTH for recipient nicks of up to
+  NAMES_NICK_RESERVE characters (no nick is longer, see handleNick). Rendered once per version of the channel, a JOIN then only
+  copies the chunks instead of concatenating every member's nick.*/
+const std::vector<std::string>	&Channel::getNamesChunks() const
+{
+	if (_namesVersion == _version)
+		return (_namesCache);
+
+	size_t		overhead = std::string(": 353  @  :\r\n").size() + std::char_traits<char>::length(SERVER_NAME)
+		+ NAMES_NICK_RESERVE + _channelName.size();
+	size_t		budget = (overhead + 64 < MAX_LINE_LENGTH) ? MAX_LINE_LENGTH - overhead : 64;
+	std::string	chunk;
+
+	_namesCache.clear();
+	for (Client *member : _userList)
+	{
+		bool op = std::find(_chOperatorList.begin(), _chOperatorList.end(), member) != _chOperatorList.end();
+		std::string nick = member->getNick();
+		if (!chunk.empty() && chunk.size() + 1 + op + nick.size() > budget)
+		{
+			_namesCache.push_back(chunk);
+			chunk.clear();
+		}
+		if (!chunk.empty())
+			chunk += ' ';
+		if (op)
+			chunk += '@';
+		chunk += nick;
+	}
+	if (!chunk.empty())
+		_namesCache.push_back(chunk);
+	_namesVersion = _version;
+	return (_namesCache);
+}
+
 /*Let the user if having operator rights (or if set topic is enabled for all members)
   set the topic of a channel.*/
 void Channel::setTopic(Client *client, const std::string& topic)
 {
 	if (!isClientInChannel(client))
 		throw ClientNotInChannelException();
-	if (_topicOperatorsOnly)
+	if (_topicOperatorsOnly && !isClientOperator(client))
 		throw ClientNotOperatorException();
 	else {
 		_topic = topic;
+		bumpVersion();
 	}
 }
 /*First checks if the client conducting the kick command is in channel and has operator rights. Then
-  loops through member list of channel in order to find the matching nick of the user to be kicked out.
-  If a match is found, calls removeClient method to kick the user otherwise throws exception.*/
-void Channel::setKick(Client *client, const std::string& channelName, std::string& nick)
+  checks if the user to be kicked out (already looked up by nick on server side, nullptr if the nick
+  does not exist) is member of the channel. If this is the case, calls removeClient method to kick
+  the user otherwise throws exception.*/
+void Channel::setKick(Client *client, Client *target)
 {
 	if (!isClientInChannel(client))
 		throw ClientNotInChannelException();
 	if (!isClientOperator(client))
 		throw ClientNotOperatorException();
-	auto it = std::find_if(_userList.begin(), _userList.end(), [&](Client* client) {
-		return client->getNick() == nick;
-	});
-	if (it != _userList.end()) {
-		removeClient(*it);
-	}
-	else {
+	if (target == nullptr || !isClientInChannel(target))
 		throw NickNotExistException();
-	}
-	std::cout << client->getNick() + " kicked out " + nick + " from " + channelName << std::endl; 
+	removeClient(target);
+	LOG(LEVEL_INFO, LOG_CHANNEL, client->getNick() << " kicked out " << target->getNick() << " from " << _channelName);
 }
 
-void Channel::setInvite(Client *client, const std::string& channelName, std::string& nick)
+void Channel::setInvite(Client *client, Client *invitee)
 {
-	(void)channelName;
-	(void) nick;
 	if (!isClientInChannel(client))
 		throw ClientNotInChannelException();
 	if (!isClientOperator(client))
 		throw ClientNotOperatorException();
-	if (isClientInChannel(getClientByNickname(nick)))
+	if (isClientInChannel(invitee))
 		throw ClientAlreadyInChannelException();
 }
 
@@ -164,16 +208,24 @@ void Channel::setInvite(Client *client, const std::string& channelName, std::str
 std::vector<Client *> &Channel::getUsers() { return (_userList); }
 
 /*Adds new client to the channel by adding it to the vector array of clients.
-  Used in joinChannel function in server.cpp*/
-void	Channel::addClient(Client *client) {_userList.push_back(client);}
+  Used in joinChannel function in server.cpp. The client's own list of joined channels is
+  updated together with the user list.*/
+void	Channel::addClient(Client *client)
+{
+	_userList.push_back(client);
+	client->addJoinedChannel(this);
+	bumpVersion();
+}
 
-/*Removes client from channel*/
+/*Removes client from channel and the channel from the client's list of joined channels*/
 void Channel::removeClient(Client *client)
 {
 	auto it = std::find(_userList.begin(), _userList.end(), client);
 	if (it != _userList.end())
 	{
 		_userList.erase(it);
+		client->removeJoinedChannel(this);
+		bumpVersion();
 	}
 }
 
@@ -201,15 +253,27 @@ void	Channel::clearParsedParameters() { _parsedParameters.clear(); }
 
 bool	Channel::getInviteOnlyState() { return (_inviteOnlyEnabled); }
 
-void	Channel::setInviteOnlyState(bool status) { _inviteOnlyEnabled = status; }
+void	Channel::setInviteOnlyState(bool status)
+{
+	_inviteOnlyEnabled = status;
+	bumpVersion();
+}
 
 int		Channel::getUserLimit() { return (_userLimit); }
 
-void	Channel::setUserLimit(int limit) { _userLimit = limit; }
+void	Channel::setUserLimit(int limit)
+{
+	_userLimit = limit;
+	bumpVersion();
+}
 
 bool	Channel::getTopicOperatorsOnlyState() { return (_topicOperatorsOnly); }
 
-void	Channel::setTopicOperatorsOnlyState(bool status) { _topicOperatorsOnly= status; }
+void	Channel::setTopicOperatorsOnlyState(bool status)
+{
+	_topicOperatorsOnly= status;
+	bumpVersion();
+}
 
 std::vector<Client *>&	Channel::getChOperatorList() { return (_chOperatorList); }
 
@@ -219,7 +283,10 @@ std::vector<Client *>&	Channel::getChOperatorList() { return (_chOperatorList);
 void	Channel::setChOperator(Client* client) {
 	auto it = std::find(_chOperatorList.begin(), _chOperatorList.end(), client);
 	if (it == _chOperatorList.end())
+	{
 		_chOperatorList.push_back(client);
+		bumpVersion();
+	}
 }
 
 /*Checks if client is in _chOperatorList and erases client from list if this is the case.
@@ -228,7 +295,10 @@ void	Channel::setChOperator(Client* client) {
 void	Channel::unsetChOperator(Client* client) {
 	auto it = std::find(_chOperatorList.begin(), _chOperatorList.end(), client);
 	if (it != _chOperatorList.end())
+	{
 		_chOperatorList.erase(it);
+		bumpVersion();
+	}
 }
 
 const char* Channel::ClientNotOperatorException::what() const noexcept {
@@ -253,14 +323,14 @@ const char* Channel::ClientAlreadyInChannelException::what() const noexcept {
 
 /*Returns amount of users within a channel.*/
 std::size_t	Channel::getNumberOfUsersInCh() const {
-	std::cout << "USER AMOUNT: " <<_userList.size() << std::endl;
+	LOG(LEVEL_DEBUG, LOG_CHANNEL, "USER AMOUNT: " << _userList.size());
 	return (_userList.size());
 }
 
 /*Called in handleJoin function in order to check whether any channel restrictions apply before user
   joins channel. If a restriction apply, a message is sent to the client with help of the passed
   messageFunc (in handle join MessageServerToClient function)*/
-bool	Channel::checkForModeRestrictions(Client &client, std::string password, std::function<void(Client&, const std::string&)> messageFunc)
+bool	Channel::checkForModeRestrictions(Client &client, std::string password, std::function<void(Client&, Reply&)> messageFunc)
 {
 	std::string	response;
 
@@ -13,10 +13,14 @@
 #pragma once
 
 #include "Client.hpp"
+#include "RecvBuffer.hpp"
 #include <vector>
 #include <functional>
 
+const size_t	NAMES_NICK_RESERVE = MAX_NICK_LENGTH;	// recipient nick length a RPL_NAMREPLY chunk leaves room for
+
 class Client;
+class Reply;
 
 class Channel {
 	public:
@@ -31,10 +35,13 @@ class Channel {
 		std::string					getChannelName() const;
 		std::string					getChannelPassw() const;
 		void						setChannelPassw(const std::string& password);
-		std::string					getMode() const;
+		const std::string			&getMode() const;
+		const std::vector<std::string>	&getNamesChunks() const;
+		uint64_t					getVersion() const;
+		void						bumpVersion();
 		void						setTopic(Client *client, const std::string& topic);
-		void						setKick(Client *client, const std::string& channelName, std::string& rest);
-		void						setInvite(Client *client, const std::string& channelName, std::string& rest);
+		void						setKick(Client *client, Client *target);
+		void						setInvite(Client *client, Client *invitee);
 		std::vector<Client*>&		getUsers();
 		void						addClient(Client* client);
 		void						removeClient(Client* client);
@@ -56,10 +63,9 @@ class Channel {
 		void						unsetChOperator(Client* client);
 		bool						isClientOperator(Client* client);
 		bool 						isClientInChannel(Client* client);
-		Client*						getClientByNickname(const std::string& nickname);
 		std::size_t					getNumberOfUsersInCh() const;
 		bool						checkForModeRestrictions(Client &client, std::string password,
-											std::function<void(Client&, const std::string&)> messageFunc);
+											std::function<void(Client&, Reply&)> messageFunc);
 		bool						isChannelOperator(Client* client);
 		bool						isOnInvitationList(Client* client); 
 		void						addToInvitationList(Client* client);
@@ -105,4 +111,10 @@ class Channel {
 		std::string					_parsedModes;
 		std::vector<std::string>	_parsedParameters;
 		std::vector<Client*>		_invitationList;
+		// replies rendered for _version, rendered again after the next change
+		uint64_t					_version;
+		mutable uint64_t			_modeVersion;
+		mutable std::string			_modeCache;
+		mutable uint64_t			_namesVersion;
+		mutable std::vector<std::string>	_namesCache;
 };
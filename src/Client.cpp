@@ -11,12 +11,21 @@
 /* **************************************************************************************** */
 
 #include "Client.hpp"
+#include <arpa/inet.h>
 
 /* ************************************************Constructor Section START*************************************** */
-Client::Client() {}
+Client::Client() : _addr(), _transport(nullptr), _closing(false), _connectedAt(0), _lastActivity(0), _pingSent(0), _operator(false), _id(0), _broadcastMark(0)
+{
+	setHost();
+}
 
 Client::Client(int fd, const sockaddr_in &client_addr)
-    : _fd(fd), _addr(client_addr), _nick("*"), _userName(""), _passwdOK(false), _nickOK(false), _userNameOK(false) {}
+    : _fd(fd), _addr(client_addr), _nick("*"), _userName(""), _passwdOK(false), _nickOK(false), _userNameOK(false),
+	  _flushPending(false), _writeInterest(false), _transport(nullptr), _closing(false), _connectedAt(0), _lastActivity(0),
+	  _pingSent(0), _operator(false), _id(0), _broadcastMark(0)
+{
+	setHost();
+}
 
 Client::Client(const Client &other)
 {
@@ -25,9 +34,24 @@ Client::Client(const Client &other)
 	this->_addr = other._addr;
 	this->_nick = other._nick;
 	this->_userName = other._userName;
+	this->_host = other._host;
+	this->_prefix = other._prefix;
 	this->_passwdOK = other._passwdOK;
 	this->_nickOK = other._nickOK;
 	this->_userNameOK = other._userNameOK; 
+	this->_sendQueue = other._sendQueue;
+	this->_recvBuffer = other._recvBuffer;
+	this->_flushPending = other._flushPending;
+	this->_writeInterest = other._writeInterest;
+	this->_transport = other._transport;
+	this->_closing = other._closing;
+	this->_joinedChannels = other._joinedChannels;
+	this->_connectedAt = other._connectedAt;
+	this->_lastActivity = other._lastActivity;
+	this->_pingSent = other._pingSent;
+	this->_operator = other._operator;
+	this->_id = other._id;
+	this->_broadcastMark = other._broadcastMark;
 }
 
 Client &Client::operator=(const Client &other)
@@ -39,9 +63,24 @@ Client &Client::operator=(const Client &other)
 		this->_addr = other._addr;
 		this->_nick = other._nick;
 		this->_userName = other._userName;
+		this->_host = other._host;
+		this->_prefix = other._prefix;
 		this->_passwdOK = other._passwdOK;
 		this->_nickOK = other._nickOK;
 		this->_userNameOK = other._userNameOK; 
+		this->_sendQueue = other._sendQueue;
+		this->_recvBuffer = other._recvBuffer;
+		this->_flushPending = other._flushPending;
+		this->_writeInterest = other._writeInterest;
+		this->_transport = other._transport;
+		this->_closing = other._closing;
+		this->_joinedChannels = other._joinedChannels;
+		this->_connectedAt = other._connectedAt;
+		this->_lastActivity = other._lastActivity;
+		this->_pingSent = other._pingSent;
+		this->_operator = other._operator;
+		this->_id = other._id;
+		this->_broadcastMark = other._broadcastMark;
 	}
 	return *this;
 }
@@ -56,13 +95,47 @@ int Client::getFd() const { return (_fd); }
 
 sockaddr_in Client::getAddr() const { return (_addr); }
 
-void Client::setNick(const std::string &value) { _nick = value; }
+void Client::setNick(const std::string &value)
+{
+	_nick = value;
+	renderPrefix();
+}
+
+const std::string &Client::getNick() const { return (_nick); }
+
+void Client::setUsername(const std::string &value)
+{
+	_userName = value;
+	renderPrefix();
+}
+
+const std::string &Client::getUsername() const { return (_userName); }
 
-std::string Client::getNick() const { return (_nick); }
+/*Address of the peer as text, the host part of the prefix*/
+const std::string &Client::getHost() const { return (_host); }
 
-void Client::setUsername(const std::string &value) { _userName = value; }
+/*Source of the messages the client sends to others, ":nick!user@host" (":nick" until USER was
+  received). Rendered when the nick or user name changes, not per message.*/
+const std::string &Client::getPrefix() const { return (_prefix); }
 
-std::string Client::getUsername() const { return (_userName); }
+void Client::setHost()
+{
+	char address[INET_ADDRSTRLEN];
+
+	if (inet_ntop(AF_INET, &_addr.sin_addr, address, sizeof(address)) == nullptr)
+		address[0] = '\0';
+	_host = address;
+	renderPrefix();
+}
+
+void Client::renderPrefix()
+{
+	_prefix.clear();
+	_prefix.reserve(_nick.size() + _userName.size() + _host.size() + 3);
+	_prefix.append(1, ':').append(_nick);
+	if (!_userName.empty())
+		_prefix.append(1, '!').append(_userName).append(1, '@').append(_host);
+}
 
 void Client::setState(clientState state) { _state = state; }
 
@@ -79,3 +152,65 @@ void Client::setNickOK(bool ok) { _nickOK = ok; }
 bool Client::getUserNameOK() { return (_userNameOK); }
 
 void Client::setUserNameOK(bool ok) { _userNameOK = ok; }
+
+SendQueue &Client::getSendQueue() { return (_sendQueue); }
+
+RecvBuffer &Client::getRecvBuffer() { return (_recvBuffer); }
+
+bool Client::isFlushPending() const { return (_flushPending); }
+
+void Client::setFlushPending(bool pending) { _flushPending = pending; }
+
+bool Client::getWriteInterest() const { return (_writeInterest); }
+
+void Client::setWriteInterest(bool enabled) { _writeInterest = enabled; }
+
+/*Event loop owning the connection*/
+Transport	*Client::getTransport() const { return (_transport); }
+
+void Client::setTransport(Transport *transport) { _transport = transport; }
+
+/*Set by the owning loop once the connection is going to be closed, no more data is read or queued*/
+bool Client::isClosing() const { return (_closing); }
+
+void Client::setClosing(bool closing) { _closing = closing; }
+
+/*Channels the client is member of. Maintained by Channel::addClient and Channel::removeClient,
+  so it always mirrors the user lists of the channels.*/
+const std::unordered_set<Channel *>	&Client::getJoinedChannels() const { return (_joinedChannels); }
+
+bool Client::isInChannel(Channel *channel) const { return (_joinedChannels.count(channel) != 0); }
+
+void Client::addJoinedChannel(Channel *channel) { _joinedChannels.insert(channel); }
+
+void Client::removeJoinedChannel(Channel *channel) { _joinedChannels.erase(channel); }
+
+/*Keepalive timer of the session, only used on the main loop (see clientTimers.cpp). It is not copied
+  with the client.*/
+Timer &Client::getTimer() { return (_timer); }
+
+uint64_t Client::getConnectedAt() const { return (_connectedAt); }
+
+void Client::setConnectedAt(uint64_t ms) { _connectedAt = ms; }
+
+uint64_t Client::getLastActivity() const { return (_lastActivity); }
+
+void Client::setLastActivity(uint64_t ms) { _lastActivity = ms; }
+
+/*Time the last unanswered PING was sent, 0 if none is pending*/
+uint64_t Client::getPingSent() const { return (_pingSent); }
+
+void Client::setPingSent(uint64_t ms) { _pingSent = ms; }
+
+bool Client::isOperator() const { return (_operator); }
+
+void Client::setOperator(bool value) { _operator = value; }
+
+uint64_t Client::getId() const { return (_id); }
+
+void Client::setId(uint64_t id) { _id = id; }
+
+/*Epoch of the last neighbor broadcast which reached the client (see Server::sendToNeighbors)*/
+uint64_t Client::getBroadcastMark() const { return (_broadcastMark); }
+
+void Client::setBroadcastMark(uint64_t epoch) { _broadcastMark = epoch; }
@@ -13,8 +13,12 @@
 #pragma once
 
 #include <string>
+#include <unordered_set>
 #include <netinet/in.h>
 #include "Channel.hpp"
+#include "SendQueue.hpp"
+#include "RecvBuffer.hpp"
+#include "TimerWheel.hpp"
 
 enum clientState
 {
@@ -24,7 +28,11 @@ enum clientState
 };
 
 class Channel;
+class Transport;
 
+/*The socket side of a client (fd, buffers, flush and closing state) belongs to its transport, the
+  event loop which accepted the connection (or a LoopbackTransport for simulated clients), the IRC
+  side (state, nick, channels, ...) to the main loop.*/
 class Client
 {
 	public:
@@ -38,9 +46,11 @@ class Client
 		void		setFd(int value);
 		int			getFd() const;
 		void		setNick(const std::string &value);
-		std::string	getNick() const;
+		const std::string	&getNick() const;
 		void		setUsername(const std::string &value);
-		std::string	getUsername() const;
+		const std::string	&getUsername() const;
+		const std::string	&getHost() const;
+		const std::string	&getPrefix() const;
 		sockaddr_in	getAddr() const;
 		void		setState(clientState state);
 		clientState	getState() const;
@@ -50,16 +60,62 @@ class Client
 		void		setNickOK(bool ok);
 		bool		getUserNameOK();
 		void		setUserNameOK(bool ok);
+		SendQueue	&getSendQueue();
+		RecvBuffer	&getRecvBuffer();
+		bool		isFlushPending() const;
+		void		setFlushPending(bool pending);
+		bool		getWriteInterest() const;
+		void		setWriteInterest(bool enabled);
+		Transport	*getTransport() const;
+		void		setTransport(Transport *transport);
+		bool		isClosing() const;
+		void		setClosing(bool closing);
+		const std::unordered_set<Channel *>	&getJoinedChannels() const;
+		bool		isInChannel(Channel *channel) const;
+		void		addJoinedChannel(Channel *channel);
+		void		removeJoinedChannel(Channel *channel);
+		Timer		&getTimer();
+		uint64_t	getConnectedAt() const;
+		void		setConnectedAt(uint64_t ms);
+		uint64_t	getLastActivity() const;
+		void		setLastActivity(uint64_t ms);
+		uint64_t	getPingSent() const;
+		void		setPingSent(uint64_t ms);
+		bool		isOperator() const;
+		void		setOperator(bool value);
+		uint64_t	getId() const;
+		void		setId(uint64_t id);
+		uint64_t	getBroadcastMark() const;
+		void		setBroadcastMark(uint64_t epoch);
 		//variables
 		bool		cap_status;
 
 	private:
+		void		setHost();
+		void		renderPrefix();
+
 		int			_fd;
 		int			_state;
 		sockaddr_in	_addr;
 		std::string	_nick;
 		std::string	_userName;
+		std::string	_host;
+		std::string	_prefix;			// see getPrefix
 		bool		_passwdOK;
 		bool		_nickOK;
 		bool		_userNameOK;
+		SendQueue	_sendQueue;
+		RecvBuffer	_recvBuffer;
+		bool		_flushPending;
+		bool		_writeInterest;
+		Transport	*_transport;
+		bool		_closing;
+		std::unordered_set<Channel *>	_joinedChannels;
+		Timer		_timer;
+		uint64_t	_connectedAt;
+		uint64_t	_lastActivity;
+		uint64_t	_pingSent;
+		bool		_operator;
+		uint64_t	_id;			// session number given by the main loop, unlike the fd never reused
+		uint64_t	_broadcastMark;
 };
@@ -0,0 +1,41 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include "IrcMessage.hpp"
+#include "Client.hpp"
+
+class Server;
+
+const int	MAX_COMMANDS = 32;
+
+/*Registration states in which a command may be used*/
+enum commandStates
+{
+	ALLOW_REGISTERING = 1,
+	ALLOW_REGISTERED = 2,
+	ALLOW_ALWAYS = ALLOW_REGISTERING | ALLOW_REGISTERED
+};
+
+struct CommandEntry
+{
+	const char	*name;
+	void		(Server::*handler)(Client &client, const IrcMessage &msg);
+	int			minParams;
+	unsigned	allowedStates;
+};
+
+const CommandEntry	*findCommand(std::string_view name);
+int					getCommandCount();
+const CommandEntry	&getCommandEntry(int index);
+int					getCommandIndex(const CommandEntry *entry);
@@ -0,0 +1,31 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <string>
+
+/*Optional runtime settings, filled from the --option=value arguments given after
+  <port> and <password> (see main.cpp)*/
+struct ServerConfig
+{
+	std::string	ioBackend = "epoll";
+	int			threads = 1;
+	int			maxClients = 999;			// connections over all event loops
+	int			listenBacklog = 1024;
+	int			pingInterval = 120;			// seconds without input until a PING is sent
+	int			pingTimeout = 60;			// seconds to answer the PING
+	int			registrationTimeout = 30;	// seconds to complete the registration
+	std::string	operPassword;				// OPER is disabled while empty
+	int			metricsPort = 0;			// admin endpoint on 127.0.0.1, 0 disables it
+	std::string	capturePath;				// inbound traffic is recorded to this file if set
+};
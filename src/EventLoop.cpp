@@ -0,0 +1,585 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "EventLoop.hpp"
+#include "Server.hpp"
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <system_error>
+
+extern volatile sig_atomic_t	server_running;
+
+/* ************************************************Constructor Section START*************************************** */
+EventLoop::EventLoop(Server &server, int id, int listenFd, const std::string &ioBackend)
+	: _server(server), _id(id), _listenFd(listenFd), _wakeFd(-1), _spareFd(-1), _poller(nullptr), _ring(nullptr), _wakeValue(0),
+	  _stopping(false), _wakePending(false), _fromMainPosted(false), _toMainPosted(false), _acceptBatch(0),
+	  _acceptedTotal(0), _rejectedTotal(0), _rateWindowStart(TimerWheel::monotonicMs()), _rateWindowCount(0), _acceptRate(0)
+{
+	_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeFd == -1)
+		throw std::system_error(errno, std::generic_category(), "eventfd failed");
+	_spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	if (ioBackend == "io_uring" && setupUring())
+		return;
+	_poller = Poller::create(ioBackend == "io_uring" ? "epoll" : ioBackend);
+	_poller->add(_listenFd, POLLER_READ);
+	_poller->add(_wakeFd, POLLER_READ);
+}
+
+/*Closes and deletes the remaining clients (including closed ones the main loop did not release
+  yet), only called once the loop's thread has been joined*/
+EventLoop::~EventLoop()
+{
+	delete _ring;
+	cleanupClients();
+	delete _poller;
+	if (_spareFd != -1)
+		close(_spareFd);
+	close(_wakeFd);
+	close(_listenFd);
+}
+
+/* ************************************************Constructor Section END*************************************** */
+
+int			EventLoop::getId() const { return (_id); }
+
+bool		EventLoop::isMainLoop() const { return (_id == 0); }
+
+const char	*EventLoop::getBackendName() const { return (_ring != nullptr ? "io_uring" : _poller->getName()); }
+
+uint64_t	EventLoop::getAcceptedTotal() const { return (_acceptedTotal.load(std::memory_order_relaxed)); }
+
+uint64_t	EventLoop::getRejectedTotal() const { return (_rejectedTotal.load(std::memory_order_relaxed)); }
+
+const LoopStats	&EventLoop::getStats() const { return (_stats); }
+
+/*Connections accepted per second, measured over the last window of at least one second which had
+  accepts. 0 once no connection was accepted for two seconds.*/
+unsigned	EventLoop::getAcceptRate() const
+{
+	if (TimerWheel::monotonicMs() - _rateWindowStart.load(std::memory_order_relaxed) >= 2000)
+		return (0);
+	return (_acceptRate.load(std::memory_order_relaxed));
+}
+
+/*Runs the loop on a thread of its own, used for every loop but the main loop*/
+void	EventLoop::start() { _thread = std::thread(&EventLoop::run, this); }
+
+/*Runs until the server is shut down. The main loop watches the flag set by the signal handler,
+  the other loops are stopped by the main loop through stop().*/
+void	EventLoop::run()
+{
+	std::vector<PollerEvent> events;
+
+	while (isMainLoop() ? server_running : !_stopping.load())
+		runOnce(events);
+}
+
+void	EventLoop::stop()
+{
+	_stopping.store(true);
+	wake();
+}
+
+void	EventLoop::join()
+{
+	if (_thread.joinable())
+		_thread.join();
+}
+
+/*One iteration: wait for ready fds (or completions), handle them, then exchange messages with the main loop. Replies
+  queued during the iteration are flushed and closed connections are removed at the end, so handlers
+  and loops over channel members may still refer to them. The main loop waits at most until the next
+  keepalive timer is due and runs the expired timers first. The main loop reaps sessions twice, before
+  flushing (to queue the CLOSE of disconnected sessions) and after removing connections (to RELEASE
+  connections closed by its own reapClients).*/
+void	EventLoop::runOnce(std::vector<PollerEvent> &events)
+{
+	int timeout = isMainLoop() ? _server.getTimerTimeout() : -1;
+	int ready = (_ring != nullptr) ? _ring->submitAndWait(1, timeout) : _poller->wait(events, timeout);
+	if (ready == -1 && errno != EAGAIN && errno != EBUSY && errno != ETIME)
+	{
+		if (errno == EINTR)
+			return;
+		LOG(LEVEL_ERROR, LOG_CORE, "Poll failed: " << std::strerror(errno));
+		if (isMainLoop())
+			server_running = 0;
+		_stopping.store(true);
+		return;
+	}
+	if (isMainLoop())
+		_server.runTimers();
+	if (_ring != nullptr)
+		handleCompletions();
+	else
+		handleEvents(events);
+	if (_acceptBatch > 0)
+		recordAccepts();
+	if (isMainLoop())
+	{
+		_server.drainLoops();
+		_server.reapClients();
+	}
+	else
+		drainFromMain();
+	flushPendingClients();
+	reapClients();
+	if (isMainLoop())
+	{
+		_server.recordLatencies();
+		_server.reapClients();
+		_server.notifyLoops();
+	}
+	else if (_toMainPosted)
+	{
+		_toMainPosted = false;
+		_server.getMainLoop()->wake();
+	}
+}
+
+/*Handles the ready fds reported by the poller. Readiness of the listening socket means that a new
+  connection can be accepted, readiness of the wake fd that another loop queued messages (they are
+  drained after the batch). Writable client sockets get their send queue flushed, readable ones are
+  handled by receiveFromClient. The client is looked up in the fd indexed slab, clients closed earlier
+  in the same batch are skipped. Their fds are only closed by reapClients after the batch, so an fd
+  can not be reused by a new connection while events for it are pending.*/
+void	EventLoop::handleEvents(const std::vector<PollerEvent> &events)
+{
+	for (const PollerEvent &event : events)
+	{
+		if (event.fd == _listenFd)
+		{
+			handleNewClient();
+			continue;
+		}
+		if (event.fd == _wakeFd)
+		{
+			uint64_t value;
+			if (read(_wakeFd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+				LOG(LEVEL_ERROR, LOG_CORE, "eventfd read failed: " << std::strerror(errno));
+			_wakePending.exchange(false);
+			continue;
+		}
+		Client *client = getClientByFd(event.fd);
+		if (client == nullptr || client->isClosing())
+			continue;
+		if (event.events & POLLER_WRITE)
+			flushClient(*client);
+		if ((event.events & (POLLER_READ | POLLER_ERROR)) && !client->isClosing())
+			receiveFromClient(*client);
+	}
+}
+
+/*Accepts the pending connections of the non-blocking listening socket, at most MAX_ACCEPTS_PER_EVENT
+  per wakeup so a connection storm does not starve the connected clients (the poller reports the
+  listening socket again while the backlog is not empty). accept4 creates the sockets non-blocking
+  and close-on-exec in one call.*/
+void	EventLoop::handleNewClient()
+{
+	for (int accepts = 0; accepts < MAX_ACCEPTS_PER_EVENT; ++accepts)
+	{
+		sockaddr_in client_addr = {};
+		socklen_t client_len = sizeof(client_addr);
+		int client_fd = accept4(_listenFd, (struct sockaddr *)&client_addr, &client_len,
+			SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (client_fd != -1)
+		{
+			acceptClient(client_fd, client_addr);
+			continue;
+		}
+		if (errno == EINTR || errno == ECONNABORTED)
+			continue;
+		if (errno == EMFILE || errno == ENFILE)
+			shedConnection();
+		else if (errno != EAGAIN && errno != EWOULDBLOCK)
+			LOG(LEVEL_ERROR, LOG_NET, "Accept failed: " << std::strerror(errno));
+		return;
+	}
+}
+
+/*Registers the accepted connection unless maxClients connections are open already*/
+void	EventLoop::acceptClient(int fd, const sockaddr_in &addr)
+{
+	if (!_server.reserveConnection())
+	{
+		rejectClient(fd);
+		return;
+	}
+	_acceptBatch++;
+	registerClient(fd, addr);
+}
+
+/*Tells the client that the server is full and closes the connection right away*/
+void	EventLoop::rejectClient(int fd)
+{
+	static const char	message[] = "ERROR :Closing Link: * (Server is full)\r\n";
+
+	if (send(fd, message, sizeof(message) - 1, MSG_DONTWAIT | MSG_NOSIGNAL) == -1)
+		errno = 0;
+	close(fd);
+	_rejectedTotal.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*Out of file descriptors: the spare fd is closed to accept (and immediately close) one pending
+  connection, otherwise it would stay in the backlog and the listening socket would be reported
+  ready again at once.*/
+void	EventLoop::shedConnection()
+{
+	LOG(LEVEL_WARN, LOG_NET, "Accept failed: " << std::strerror(errno) << ", shedding a connection");
+	if (_spareFd == -1)
+		return;
+	close(_spareFd);
+	int fd = accept4(_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd != -1)
+		rejectClient(fd);
+	_spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+/*Updates the accept metrics once per iteration and logs the accepted connections*/
+void	EventLoop::recordAccepts()
+{
+	uint64_t now = TimerWheel::monotonicMs();
+	uint64_t elapsed = now - _rateWindowStart.load(std::memory_order_relaxed);
+
+	_acceptedTotal.fetch_add(_acceptBatch, std::memory_order_relaxed);
+	if (elapsed >= 2000)
+		_rateWindowCount = 0;
+	else if (elapsed >= 1000)
+		_acceptRate.store(_rateWindowCount * 1000 / elapsed, std::memory_order_relaxed);
+	if (elapsed >= 1000)
+	{
+		_rateWindowStart.store(now, std::memory_order_relaxed);
+		_rateWindowCount = 0;
+	}
+	_rateWindowCount += _acceptBatch;
+	LOG(LEVEL_INFO, LOG_NET, "Accepted " << _acceptBatch << " connection(s) on loop " << _id << ", "
+		<< _server.getConnectionCount() << " open, " << getAcceptRate() << "/s");
+	_acceptBatch = 0;
+}
+
+/*Creates the client of an accepted, non-blocking socket and starts receiving from it. The main loop
+  is told about it to start the registration timeout.*/
+void	EventLoop::registerClient(int fd, const sockaddr_in &addr)
+{
+	Client *client = new Client(fd, addr);
+	client->setState(REGISTERING);
+	client->setTransport(this);
+	addClient(client);
+	if (_ring != nullptr)
+		armRecv(*client);
+	else
+		_poller->add(fd, POLLER_READ);
+	postToMain({LOOP_CONNECT, client, nullptr});
+}
+
+/*Reads from the client socket into the client's receive buffer and passes every complete line
+  to the main loop. Incomplete lines are kept in the buffer until the next read. Reads are
+  repeated until the socket is drained, at most MAX_READS_PER_EVENT times so a single busy client
+  cannot starve the others (level triggered polling reports the fd again).*/
+void	EventLoop::receiveFromClient(Client &client)
+{
+	RecvBuffer	&buffer = client.getRecvBuffer();
+	bool		drained = false;
+
+	for (int reads = 0; reads < MAX_READS_PER_EVENT && !drained; ++reads)
+	{
+		ssize_t bytes_read = buffer.readFrom(client.getFd(), drained);
+		if (bytes_read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			return;
+		if (bytes_read <= 0)
+		{
+			LOG(LEVEL_INFO, LOG_NET, "Client disconnected on fd " << client.getFd());
+			_server.getMetrics().disconnected(bytes_read == 0 ? DISCONNECT_PEER_CLOSED : DISCONNECT_READ_ERROR);
+			closeClient(client);
+			return;
+		}
+		addCounter(_stats.bytesIn, bytes_read);
+		if (!processLines(client, Metrics::monotonicMicros()))
+			return;
+	}
+}
+
+/*Passes the complete lines in the client's receive buffer on. On the main loop lines are handled
+  right away, the other loops queue a copy of the line. receivedAt (time of the read) is the start
+  of the command latency. Returns false once the client is disconnected or closing, nothing more
+  should be read from it then.*/
+bool	EventLoop::processLines(Client &client, uint64_t receivedAt)
+{
+	RecvBuffer	&buffer = client.getRecvBuffer();
+	const char	*line;
+	size_t		length;
+	lineStatus	status;
+
+	while ((status = buffer.nextLine(line, length)) != LINE_NONE)
+	{
+		if (isMainLoop())
+		{
+			if (status == LINE_TOO_LONG)
+				_server.inputTooLong(client);
+			else
+				_server.handleClientMessage(client, std::string_view(line, length), receivedAt);
+			if (client.getState() == DISCONNECTED)
+				return (false);
+		}
+		else if (status == LINE_TOO_LONG)
+			postToMain({LOOP_LINE_TOO_LONG, &client, nullptr});
+		else
+			postToMain({LOOP_LINE, &client, std::make_shared<const std::string>(line, length), receivedAt});
+		if (client.isClosing())
+			return (false);
+	}
+	return (true);
+}
+
+/*Appends a line to the client's send queue, the queue is written to the socket at the end of the
+  current iteration (or once the socket is writable again). Clients whose queue overflows are closed.*/
+void	EventLoop::queueLine(Client &client, const SharedLine &line)
+{
+	if (client.isClosing())
+		return;
+	if (!client.getSendQueue().push(line))
+	{
+		LOG(LEVEL_WARN, LOG_NET, "SendQ exceeded, dropping client on fd " << client.getFd());
+		_server.getMetrics().disconnected(DISCONNECT_SENDQ_EXCEEDED);
+		closeClient(client);
+		return;
+	}
+	addCounter(_stats.queuedBytes, line->size());
+	if (client.getSendQueue().getBytes() > _stats.queuePeak.load(std::memory_order_relaxed))
+		_stats.queuePeak.store(client.getSendQueue().getBytes(), std::memory_order_relaxed);
+	if (!client.isFlushPending() && !client.getWriteInterest())
+	{
+		client.setFlushPending(true);
+		_pendingFlush.push_back(&client);
+	}
+}
+
+/*Writes as much of the client's send queue as the socket accepts. Write interest is only
+  registered while data is left over, so idle clients never wake up the poller for POLLOUT.
+  The io_uring backend queues a send request instead.*/
+void	EventLoop::flushClient(Client &client)
+{
+	if (_ring != nullptr)
+	{
+		submitSend(client);
+		return;
+	}
+	size_t queued = client.getSendQueue().getBytes();
+	flushResult result = client.getSendQueue().flush(client.getFd());
+	sentFromQueue(queued - client.getSendQueue().getBytes());
+	if (result == FLUSH_ERROR)
+	{
+		_server.getMetrics().disconnected(DISCONNECT_WRITE_ERROR);
+		closeClient(client);
+		return;
+	}
+	bool wantWrite = (result == FLUSH_AGAIN);
+	if (wantWrite != client.getWriteInterest())
+	{
+		_poller->modify(client.getFd(), wantWrite ? POLLER_READ | POLLER_WRITE : POLLER_READ);
+		client.setWriteInterest(wantWrite);
+	}
+}
+
+/*Flushes every client which got new messages queued during the current iteration. Lines
+  queued for the same client are written with one writev call.*/
+void	EventLoop::flushPendingClients()
+{
+	for (size_t i = 0; i < _pendingFlush.size(); ++i)
+	{
+		Client *client = _pendingFlush[i];
+		client->setFlushPending(false);
+		if (!client->isClosing())
+			flushClient(*client);
+	}
+	_pendingFlush.clear();
+}
+
+/*Bytes of the send queues written to the sockets*/
+void	EventLoop::sentFromQueue(size_t bytes)
+{
+	addCounter(_stats.bytesOut, bytes);
+	_stats.queuedBytes.store(_stats.queuedBytes.load(std::memory_order_relaxed) - bytes, std::memory_order_relaxed);
+}
+
+/*Marks the connection for closing. The client object stays valid until the main loop releases it.*/
+void	EventLoop::closeClient(Client &client)
+{
+	if (client.isClosing())
+		return;
+	client.setClosing(true);
+	_pendingClose.push_back(&client);
+}
+
+/*Closes the connections marked by closeClient. Tries to send what is left in the send queue
+  (e.g. error replies before closing the link), then closes the socket and tells the main loop,
+  which removes the session and releases the client.
+  With io_uring the send requests prepared in this iteration are submitted before any fd is closed,
+  so the fd can not be reused by an accept in between. A send already in flight owns the rest of
+  the queue, a synchronous write next to it could reorder the data. The requests still armed keep
+  the socket open, shutdown() ends them.*/
+void	EventLoop::reapClients()
+{
+	if (_ring != nullptr && !_pendingClose.empty())
+		_ring->submit();
+	for (Client *client : _pendingClose)
+	{
+		int fd = client->getFd();
+		size_t queued = client->getSendQueue().getBytes();
+		if (_ring == nullptr || !client->getWriteInterest())
+			client->getSendQueue().flush(fd);
+		sentFromQueue(queued - client->getSendQueue().getBytes());
+		size_t dropped = client->getSendQueue().getBytes();
+		_stats.queuedBytes.store(_stats.queuedBytes.load(std::memory_order_relaxed) - dropped, std::memory_order_relaxed);
+		client->getSendQueue().clear();
+		removeClient(fd);
+		if (_ring != nullptr)
+			shutdown(fd, SHUT_RDWR);
+		close(fd);
+		_server.releaseConnection();
+		_detached.insert(client);
+		postToMain({LOOP_DISCONNECT, client, nullptr});
+	}
+	_pendingClose.clear();
+}
+
+/*Messages from the main loop, handled by the loop owning the connection*/
+void	EventLoop::handleMessage(const LoopMessage &message)
+{
+	if (message.type == LOOP_SEND)
+		queueLine(*message.client, message.line);
+	else if (message.type == LOOP_CLOSE)
+		closeClient(*message.client);
+	else if (message.type == LOOP_RELEASE)
+	{
+		_detached.erase(message.client);
+		delete message.client;
+	}
+}
+
+void	EventLoop::postToMain(const LoopMessage &message)
+{
+	if (isMainLoop())
+	{
+		_server.handleLoopMessage(message);
+		return;
+	}
+	_toMain.push(message);
+	_toMainPosted = true;
+}
+
+/*Called on the main loop. Messages for connections of the main loop itself are handled at once.*/
+void	EventLoop::postFromMain(const LoopMessage &message)
+{
+	if (isMainLoop())
+	{
+		handleMessage(message);
+		return;
+	}
+	_fromMain.push(message);
+	_fromMainPosted = true;
+}
+
+/*Called on the main loop, passes the messages queued by this loop to the server*/
+void	EventLoop::drainToMain()
+{
+	LoopMessage message;
+
+	while (_toMain.pop(message))
+		_server.handleLoopMessage(message);
+}
+
+void	EventLoop::drainFromMain()
+{
+	LoopMessage message;
+
+	while (_fromMain.pop(message))
+		handleMessage(message);
+}
+
+/*Called on the main loop after an iteration, wakes this loop if messages were queued for it*/
+void	EventLoop::notify()
+{
+	if (!_fromMainPosted)
+		return;
+	_fromMainPosted = false;
+	wake();
+}
+
+/*Wakes the loop up from the poller wait. Only the first wake-up until the loop handled the wake fd
+  costs a write.*/
+void	EventLoop::wake()
+{
+	uint64_t value = 1;
+
+	if (_wakePending.exchange(true))
+		return;
+	if (write(_wakeFd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+		LOG(LEVEL_ERROR, LOG_CORE, "eventfd write failed: " << std::strerror(errno));
+}
+
+/*Stores the client in the slot of its fd. The slab only grows when a higher fd than ever before
+  is handed out by the kernel, which reuses the lowest free fd. The generation of the slot changes
+  with every connection, io_uring completions of a previous connection on the fd are ignored.*/
+void	EventLoop::addClient(Client *client)
+{
+	size_t slot = static_cast<size_t>(client->getFd());
+	if (slot >= _clients.size())
+	{
+		_clients.resize(slot + 1, nullptr);
+		_generations.resize(slot + 1, 0);
+	}
+	_clients[slot] = client;
+	_generations[slot]++;
+}
+
+/*Unregisters the fd from the poller and empties its slot. Deleting the client is left to the
+  RELEASE from the main loop, closing the fd to the caller.*/
+void	EventLoop::removeClient(int fd)
+{
+	if (_poller != nullptr)
+		_poller->remove(fd);
+	if (fd >= 0 && static_cast<size_t>(fd) < _clients.size())
+		_clients[fd] = nullptr;
+}
+
+/*Returns Client object owning the passed socket fd or nullptr if the fd does not belong to any client.*/
+Client	*EventLoop::getClientByFd(int fd)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _clients.size())
+		return (nullptr);
+	return (_clients[fd]);
+}
+
+void	EventLoop::cleanupClients()
+{
+	for (Client *&client : _clients)
+	{
+		if (client == nullptr)
+			continue;
+		close(client->getFd());
+		delete client;
+		client = nullptr;
+	}
+	for (Client *client : _detached)
+		delete client;
+	_detached.clear();
+	for (UringSend *send : _sends)
+		delete send;
+	_sends.clear();
+	_freeSends.clear();
+}
@@ -0,0 +1,152 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include "Client.hpp"
+#include "IoUring.hpp"
+#include "Metrics.hpp"
+#include "Poller.hpp"
+#include "SendQueue.hpp"
+#include "SpscQueue.hpp"
+#include "Transport.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+const int MAX_READS_PER_EVENT = 4;
+const int MAX_ACCEPTS_PER_EVENT = 64;
+
+class Server;
+
+/*Send request in flight on the io_uring backend. It holds references to the queued lines it
+  describes, so their buffers stay valid even if the connection is closed before the completion.*/
+struct UringSend
+{
+	int						fd = -1;
+	uint32_t				generation = 0;
+	std::vector<SharedLine>	lines;
+	struct iovec			iov[SENDQ_IOV_BATCH];
+	struct msghdr			message;
+};
+
+/*One reactor: a poller (or an io_uring), a listening socket and the connections accepted on it. A loop owns the
+  socket side of its clients (fd, receive buffer, send queue), all IRC state (sessions, nicks,
+  channels) is owned by the Server and only touched on the main loop, loop 0. With a single loop
+  everything runs on the calling thread and no message is queued.
+
+  Life cycle of a connection owned by another loop: when the socket fails or the main loop asks to
+  CLOSE it, the owner closes the fd and sends DISCONNECT to the main loop, which removes the session
+  and answers with RELEASE. Only then the owner deletes the Client, so pointers held by the main
+  loop always stay valid.
+
+  With the io_uring backend the loop is driven by completions instead of readiness: the listening
+  socket has a multishot accept armed, every connection a multishot recv into provided buffers and
+  the send queues are written with SENDMSG requests. All requests prepared during an iteration are
+  submitted with the wait of the next one (see uringEvents.cpp).*/
+class EventLoop : public Transport
+{
+	public:
+		EventLoop(Server &server, int id, int listenFd, const std::string &ioBackend);
+		~EventLoop();
+
+		int				getId() const;
+		bool			isMainLoop() const;
+		const char		*getBackendName() const;
+		uint64_t		getAcceptedTotal() const;
+		uint64_t		getRejectedTotal() const;
+		unsigned		getAcceptRate() const;
+		const LoopStats	&getStats() const;
+		void			start();
+		void			run();
+		void			stop();
+		void			join();
+
+		// owner side
+		void			queueLine(Client &client, const SharedLine &line);
+		void			closeClient(Client &client);
+		// main loop side
+		void			postFromMain(const LoopMessage &message) override;
+		void			drainToMain();
+		void			notify();
+
+	private:
+		EventLoop(const EventLoop &other);
+		EventLoop &operator=(const EventLoop &other);
+
+		void			runOnce(std::vector<PollerEvent> &events);
+		void			handleEvents(const std::vector<PollerEvent> &events);
+		void			handleNewClient();
+		void			acceptClient(int fd, const sockaddr_in &addr);
+		void			rejectClient(int fd);
+		void			shedConnection();
+		void			recordAccepts();
+		void			registerClient(int fd, const sockaddr_in &addr);
+		void			receiveFromClient(Client &client);
+		bool			processLines(Client &client, uint64_t receivedAt);
+		void			flushClient(Client &client);
+		void			flushPendingClients();
+		void			sentFromQueue(size_t bytes);
+		void			reapClients();
+		void			postToMain(const LoopMessage &message);
+		void			handleMessage(const LoopMessage &message);
+		void			drainFromMain();
+		void			wake();
+		void			addClient(Client *client);
+		void			removeClient(int fd);
+		Client			*getClientByFd(int fd);
+		void			cleanupClients();
+		// uringEvents.cpp
+		void			handleCompletions();
+		void			handleCompletion(const struct io_uring_cqe &cqe);
+		void			acceptCompleted(const struct io_uring_cqe &cqe);
+		void			recvCompleted(const struct io_uring_cqe &cqe);
+		void			sendCompleted(const struct io_uring_cqe &cqe);
+		void			wakeCompleted(const struct io_uring_cqe &cqe);
+		Client			*getCompletionClient(uint32_t fd, uint32_t generation);
+		void			armRecv(Client &client);
+		void			submitSend(Client &client);
+		bool			setupUring();
+
+		Server					&_server;
+		int						_id;
+		int						_listenFd;
+		int						_wakeFd;
+		int						_spareFd;		// given up to shed connections on EMFILE
+		Poller					*_poller;		// nullptr with the io_uring backend
+		IoUring					*_ring;
+		uint64_t				_wakeValue;		// read target of the io_uring wake fd read
+		std::thread				_thread;
+		std::atomic<bool>		_stopping;
+		std::atomic<bool>		_wakePending;
+		std::vector<Client *>	_clients;		// indexed by fd
+		std::vector<uint32_t>	_generations;	// indexed by fd, tags io_uring requests
+		std::vector<UringSend *>	_sends;
+		std::vector<uint32_t>	_freeSends;
+		std::vector<Client *>	_pendingFlush;
+		std::vector<Client *>	_pendingClose;
+		std::unordered_set<Client *>	_detached;	// closed, waiting for RELEASE
+		SpscQueue<LoopMessage>	_fromMain;
+		SpscQueue<LoopMessage>	_toMain;
+		bool					_fromMainPosted;	// main loop owned
+		bool					_toMainPosted;
+		// accept metrics, read by other threads
+		unsigned				_acceptBatch;		// accepted in the current iteration
+		std::atomic<uint64_t>	_acceptedTotal;
+		std::atomic<uint64_t>	_rejectedTotal;
+		std::atomic<uint64_t>	_rateWindowStart;
+		unsigned				_rateWindowCount;
+		std::atomic<unsigned>	_acceptRate;
+		LoopStats				_stats;
+};
@@ -0,0 +1,274 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "IoUring.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+const uint64_t	URING_PROBE_DATA = ~0ULL;
+
+/* ************************************************Constructor Section START*************************************** */
+/*Creates the ring, maps the submission and completion queues and provides the receive buffers.
+  Multishot recv can not be detected through feature flags, a short self test on a socketpair
+  checks it instead.*/
+IoUring::IoUring()
+	: _ringFd(-1), _ringMem(MAP_FAILED), _ringSize(0), _sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)),
+	  _sqesSize(0), _sqHead(nullptr), _sqTail(nullptr), _sqMask(0), _sqEntries(0), _sqLocalTail(0),
+	  _cqHead(nullptr), _cqTail(nullptr), _cqMask(0), _cqes(nullptr)
+{
+	struct io_uring_params params;
+
+	std::memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = URING_QUEUE_DEPTH * 4;
+	_ringFd = syscall(__NR_io_uring_setup, URING_QUEUE_DEPTH, &params);
+	if (_ringFd == -1)
+		throw std::system_error(errno, std::generic_category(), "io_uring_setup failed");
+	unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL | IORING_FEAT_CQE_SKIP
+		| IORING_FEAT_EXT_ARG;
+	if ((params.features & required) != required)
+	{
+		unmapRings();
+		throw std::system_error(ENOTSUP, std::generic_category(), "io_uring lacks required features");
+	}
+	size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	_ringSize = sqSize > cqSize ? sqSize : cqSize;
+	_ringMem = mmap(nullptr, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd,
+		IORING_OFF_SQ_RING);
+	_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	_sqes = static_cast<struct io_uring_sqe *>(mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES));
+	if (_ringMem == MAP_FAILED || _sqes == MAP_FAILED)
+	{
+		int error = errno;
+		unmapRings();
+		throw std::system_error(error, std::generic_category(), "io_uring mmap failed");
+	}
+	char *ring = static_cast<char *>(_ringMem);
+	_sqHead = reinterpret_cast<unsigned *>(ring + params.sq_off.head);
+	_sqTail = reinterpret_cast<unsigned *>(ring + params.sq_off.tail);
+	_sqMask = *reinterpret_cast<unsigned *>(ring + params.sq_off.ring_mask);
+	_sqEntries = params.sq_entries;
+	_sqLocalTail = *_sqTail;
+	unsigned *sqArray = reinterpret_cast<unsigned *>(ring + params.sq_off.array);
+	for (unsigned i = 0; i < _sqEntries; i++)
+		sqArray[i] = i;
+	_cqHead = reinterpret_cast<unsigned *>(ring + params.cq_off.head);
+	_cqTail = reinterpret_cast<unsigned *>(ring + params.cq_off.tail);
+	_cqMask = *reinterpret_cast<unsigned *>(ring + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<struct io_uring_cqe *>(ring + params.cq_off.cqes);
+	_buffers.resize(URING_RECV_BUFFERS * URING_RECV_BUFFER_SIZE);
+	try {
+		provideBuffers(0, URING_RECV_BUFFERS);
+		probeMultishotRecv();
+	}
+	catch (...) {
+		unmapRings();
+		throw;
+	}
+}
+
+/*Closing the ring cancels the requests still armed (multishot accept and recv)*/
+IoUring::~IoUring() { unmapRings(); }
+
+/* ************************************************Constructor Section END*************************************** */
+
+void	IoUring::unmapRings()
+{
+	if (_ringFd != -1)
+		close(_ringFd);
+	_ringFd = -1;
+	if (_sqes != MAP_FAILED)
+		munmap(_sqes, _sqesSize);
+	_sqes = static_cast<struct io_uring_sqe *>(MAP_FAILED);
+	if (_ringMem != MAP_FAILED)
+		munmap(_ringMem, _ringSize);
+	_ringMem = MAP_FAILED;
+}
+
+/*Arms a multishot recv on one end of a socketpair and writes to the other end. Kernels before 6.0
+  fail the request with EINVAL. Closing the writing end ends the request again (EOF).*/
+void	IoUring::probeMultishotRecv()
+{
+	struct io_uring_cqe	cqe;
+	int					pair[2];
+	int					result = 0;
+	bool				armed = true;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) == -1)
+		throw std::system_error(errno, std::generic_category(), "socketpair failed");
+	prepareRecv(pair[0], URING_PROBE_DATA);
+	if (write(pair[1], "", 1) != 1 || submitAndWait(1, -1) == -1)
+		result = -errno;
+	close(pair[1]);
+	while (result == 0 && armed)
+	{
+		while (nextCompletion(cqe))
+		{
+			if (cqe.flags & IORING_CQE_F_BUFFER)
+				recycleBuffer(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+			if (cqe.res < 0)
+				result = cqe.res;
+			armed = (cqe.flags & IORING_CQE_F_MORE);
+		}
+		if (result == 0 && armed && submitAndWait(1, -1) == -1 && errno != EINTR)
+			result = -errno;
+	}
+	close(pair[0]);
+	if (result < 0)
+		throw std::system_error(-result, std::generic_category(), "io_uring multishot recv unsupported");
+}
+
+/*Returns a free submission queue entry, if the queue is full the prepared entries are submitted
+  first*/
+struct io_uring_sqe	*IoUring::getSqe()
+{
+	while (_sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries)
+	{
+		if (submit() == -1 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			throw std::system_error(errno, std::generic_category(), "io_uring_enter failed");
+	}
+	struct io_uring_sqe *sqe = &_sqes[_sqLocalTail & _sqMask];
+	std::memset(sqe, 0, sizeof(*sqe));
+	_sqLocalTail++;
+	return (sqe);
+}
+
+/*Accepts connections until it fails or is cancelled, every accepted socket is reported in a
+  completion of its own and created non-blocking*/
+void	IoUring::prepareAccept(int listenFd, uint64_t userData)
+{
+	struct io_uring_sqe *sqe = getSqe();
+
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = listenFd;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	sqe->user_data = userData;
+}
+
+/*Receives into provided buffers until the connection is closed, fails or runs out of buffers.
+  Completions carry IORING_CQE_F_MORE as long as the request stays armed.*/
+void	IoUring::prepareRecv(int fd, uint64_t userData)
+{
+	struct io_uring_sqe *sqe = getSqe();
+
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BUFFER_GROUP;
+	sqe->user_data = userData;
+}
+
+/*The message and the buffers it refers to have to stay valid until the completion*/
+void	IoUring::prepareSend(int fd, const struct msghdr *message, uint64_t userData)
+{
+	struct io_uring_sqe *sqe = getSqe();
+
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uint64_t>(message);
+	sqe->len = 1;
+	sqe->msg_flags = MSG_NOSIGNAL;
+	sqe->user_data = userData;
+}
+
+void	IoUring::prepareRead(int fd, void *buffer, unsigned length, uint64_t userData)
+{
+	struct io_uring_sqe *sqe = getSqe();
+
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uint64_t>(buffer);
+	sqe->len = length;
+	sqe->off = static_cast<uint64_t>(-1);
+	sqe->user_data = userData;
+}
+
+/*One shot poll for the events (POLLIN, ...) of the fd*/
+void	IoUring::preparePoll(int fd, unsigned events, uint64_t userData)
+{
+	struct io_uring_sqe *sqe = getSqe();
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = events;
+	sqe->user_data = userData;
+}
+
+/*Submits the prepared entries and, if waitNr is not 0, waits for completions, at most timeoutMs
+  milliseconds unless it is -1. Returns -1 with errno set on failure, ETIME if the timeout expired.*/
+int	IoUring::enter(unsigned waitNr, int timeoutMs)
+{
+	struct io_uring_getevents_arg	arg;
+	struct __kernel_timespec		timeout;
+
+	__atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+	unsigned pending = _sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+	if (pending == 0 && waitNr == 0)
+		return (0);
+	unsigned flags = (waitNr > 0) ? IORING_ENTER_GETEVENTS : 0;
+	if (waitNr == 0 || timeoutMs < 0)
+		return (syscall(__NR_io_uring_enter, _ringFd, pending, waitNr, flags, nullptr, 0));
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+	std::memset(&arg, 0, sizeof(arg));
+	arg.ts = reinterpret_cast<uint64_t>(&timeout);
+	return (syscall(__NR_io_uring_enter, _ringFd, pending, waitNr, flags | IORING_ENTER_EXT_ARG, &arg,
+		sizeof(arg)));
+}
+
+int	IoUring::submit() { return (enter(0, -1)); }
+
+int	IoUring::submitAndWait(unsigned waitNr, int timeoutMs) { return (enter(waitNr, timeoutMs)); }
+
+/*Copies the next completion into cqe and frees its slot. Returns false if none is pending.*/
+bool	IoUring::nextCompletion(struct io_uring_cqe &cqe)
+{
+	unsigned head = *_cqHead;
+
+	if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+		return (false);
+	cqe = _cqes[head & _cqMask];
+	__atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+	return (true);
+}
+
+const char	*IoUring::getBuffer(uint16_t id) const
+{
+	return (_buffers.data() + static_cast<size_t>(id) * URING_RECV_BUFFER_SIZE);
+}
+
+/*Hands count buffers starting at id to the kernel as buffer group URING_BUFFER_GROUP. Only a
+  failure posts a completion (with user data 0).*/
+void	IoUring::provideBuffers(uint16_t id, unsigned count)
+{
+	struct io_uring_sqe *sqe = getSqe();
+
+	sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+	sqe->fd = count;
+	sqe->addr = reinterpret_cast<uint64_t>(getBuffer(id));
+	sqe->len = URING_RECV_BUFFER_SIZE;
+	sqe->off = id;
+	sqe->buf_group = URING_BUFFER_GROUP;
+	sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+	sqe->user_data = 0;
+}
+
+/*Gives a provided buffer back to the kernel, the request goes out with the next submission*/
+void	IoUring::recycleBuffer(uint16_t id) { provideBuffers(id, 1); }
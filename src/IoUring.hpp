@@ -0,0 +1,81 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const unsigned	URING_QUEUE_DEPTH = 1024;
+const unsigned	URING_RECV_BUFFERS = 512;
+const size_t	URING_RECV_BUFFER_SIZE = 2048;
+const uint16_t	URING_BUFFER_GROUP = 0;
+
+/*Minimal io_uring wrapper on top of the raw system calls. Requests are prepared in the submission
+  queue and handed to the kernel together with the next wait, so everything queued during one loop
+  iteration costs a single io_uring_enter. Receives use provided buffers: the kernel picks a free
+  buffer per completion, its id is passed back in the completion and the buffer has to be given
+  back with recycleBuffer() once the data was consumed. Buffers are provided with
+  IORING_OP_PROVIDE_BUFFERS requests rather than a registered buffer ring, which is not reliable
+  on every kernel.
+
+  The constructor throws std::system_error if the kernel lacks io_uring or one of the features
+  used here (multishot accept: 5.19, multishot recv: 6.0), the caller is then expected to fall
+  back to a readiness based Poller. Completions with user data 0 belong to the ring itself.*/
+class IoUring
+{
+	public:
+		IoUring();
+		IoUring(const IoUring &other) = delete;
+		IoUring &operator=(const IoUring &other) = delete;
+		~IoUring();
+
+		void		prepareAccept(int listenFd, uint64_t userData);
+		void		prepareRecv(int fd, uint64_t userData);
+		void		prepareSend(int fd, const struct msghdr *message, uint64_t userData);
+		void		prepareRead(int fd, void *buffer, unsigned length, uint64_t userData);
+		void		preparePoll(int fd, unsigned events, uint64_t userData);
+		int			submit();
+		int			submitAndWait(unsigned waitNr, int timeoutMs);
+		bool		nextCompletion(struct io_uring_cqe &cqe);
+		const char	*getBuffer(uint16_t id) const;
+		void		recycleBuffer(uint16_t id);
+
+	private:
+		struct io_uring_sqe	*getSqe();
+		int					enter(unsigned waitNr, int timeoutMs);
+		void				provideBuffers(uint16_t id, unsigned count);
+		void				probeMultishotRecv();
+		void				unmapRings();
+
+		int						_ringFd;
+		void					*_ringMem;
+		size_t					_ringSize;
+		struct io_uring_sqe		*_sqes;
+		size_t					_sqesSize;
+		// submission queue
+		unsigned				*_sqHead;
+		unsigned				*_sqTail;
+		unsigned				_sqMask;
+		unsigned				_sqEntries;
+		unsigned				_sqLocalTail;
+		// completion queue
+		unsigned				*_cqHead;
+		unsigned				*_cqTail;
+		unsigned				_cqMask;
+		struct io_uring_cqe		*_cqes;
+		// provided receive buffers
+		std::vector<char>		_buffers;
+};
@@ -0,0 +1,77 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "IrcMessage.hpp"
+
+/*Returns the parameter at index or an empty view if the message has less parameters*/
+std::string_view	IrcMessage::param(int index) const
+{
+	if (index < 0 || index >= paramCount)
+		return (std::string_view());
+	return (params[index]);
+}
+
+/*Splits a line (without \r\n) into prefix, command and parameters, the way RFC 1459 2.3.1
+  describes it. Parameters are separated by one or more spaces, a parameter starting with ':'
+  (or the 15th parameter) takes the rest of the line including spaces. Nothing is copied, all
+  parts are views into line. Returns false if the line contains no command.*/
+bool	parseIrcMessage(std::string_view line, IrcMessage &message)
+{
+	size_t	pos = 0;
+	size_t	len = line.size();
+
+	message.line = line;
+	message.prefix = std::string_view();
+	message.command = std::string_view();
+	message.paramCount = 0;
+	message.hasTrailing = false;
+	while (pos < len && line[pos] == ' ')
+		pos++;
+	if (pos < len && line[pos] == ':')
+	{
+		size_t end = line.find(' ', pos);
+		if (end == std::string_view::npos)
+			return (false);
+		message.prefix = line.substr(pos + 1, end - pos - 1);
+		pos = end;
+		while (pos < len && line[pos] == ' ')
+			pos++;
+	}
+	size_t end = line.find(' ', pos);
+	if (end == std::string_view::npos)
+		end = len;
+	message.command = line.substr(pos, end - pos);
+	if (message.command.empty())
+		return (false);
+	pos = end;
+	while (pos < len)
+	{
+		while (pos < len && line[pos] == ' ')
+			pos++;
+		if (pos >= len)
+			break;
+		if (line[pos] == ':' || message.paramCount == MAX_PARAMS - 1)
+		{
+			if (line[pos] == ':')
+				pos++;
+			message.params[message.paramCount++] = line.substr(pos);
+			message.hasTrailing = true;
+			break;
+		}
+		end = line.find(' ', pos);
+		if (end == std::string_view::npos)
+			end = len;
+		message.params[message.paramCount++] = line.substr(pos, end - pos);
+		pos = end;
+	}
+	return (true);
+}
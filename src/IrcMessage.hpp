@@ -0,0 +1,33 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <string_view>
+
+const int MAX_PARAMS = 15;
+
+/*One parsed protocol line: [:prefix] command params [:trailing]. All fields are views into the
+  line passed to parseIrcMessage, so the message is only valid as long as that line is.*/
+struct IrcMessage
+{
+	std::string_view	line;
+	std::string_view	prefix;
+	std::string_view	command;
+	std::string_view	params[MAX_PARAMS];
+	int					paramCount = 0;
+	bool				hasTrailing = false;
+
+	std::string_view	param(int index) const;
+};
+
+bool	parseIrcMessage(std::string_view line, IrcMessage &message);
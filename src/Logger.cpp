@@ -0,0 +1,228 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Logger.hpp"
+#include <strings.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+
+LogRecord				Logger::_records[LOG_RING_SIZE];
+std::atomic<size_t>		Logger::_tail(0);
+size_t					Logger::_head = 0;
+std::atomic<uint64_t>	Logger::_dropped(0);
+std::atomic<bool>		Logger::_running(false);
+std::thread				Logger::_thread;
+
+static const char	*levelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+static const char	*categoryNames[] = {"core", "net", "proto", "channel", "client"};
+
+static uint64_t	realtimeMs()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000);
+}
+
+/*Copies the message into the next free slot of the ring (the position is claimed with a
+  compare-and-swap, so the loops never block each other). Drops it if the ring is full.*/
+void	Logger::write(logLevel level, logCategory category, const std::string &text)
+{
+	if (!_running.load(std::memory_order_acquire))
+	{
+		LogRecord	record;
+		std::string	out;
+
+		record.timeMs = realtimeMs();
+		record.level = level;
+		record.category = category;
+		record.length = std::min(text.size(), LOG_TEXT_SIZE);
+		std::memcpy(record.text, text.data(), record.length);
+		format(out, record);
+		output(level >= LEVEL_WARN ? STDERR_FILENO : STDOUT_FILENO, out);
+		return;
+	}
+	size_t		position = _tail.load(std::memory_order_relaxed);
+	LogRecord	*record;
+	while (true)
+	{
+		record = &_records[position & (LOG_RING_SIZE - 1)];
+		size_t sequence = record->sequence.load(std::memory_order_acquire);
+		if (sequence == position)
+		{
+			if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (sequence < position)
+		{
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+			position = _tail.load(std::memory_order_relaxed);
+	}
+	record->timeMs = realtimeMs();
+	record->level = level;
+	record->category = category;
+	record->length = std::min(text.size(), LOG_TEXT_SIZE);
+	std::memcpy(record->text, text.data(), record->length);
+	record->sequence.store(position + 1, std::memory_order_release);
+}
+
+void	Logger::setLevel(logCategory category, logLevel level)
+{
+	_levels[category].store(level, std::memory_order_relaxed);
+}
+
+/*Applies a comma separated list of category:level pairs, e.g. "proto:trace,net:debug". The
+  category "all" sets every category. Returns false (after applying the valid pairs before it) on
+  an unknown category or level.*/
+bool	Logger::configure(const std::string &spec)
+{
+	size_t start = 0;
+
+	while (start <= spec.size())
+	{
+		size_t end = spec.find(',', start);
+		if (end == std::string::npos)
+			end = spec.size();
+		std::string pair = spec.substr(start, end - start);
+		size_t colon = pair.find(':');
+		if (colon == std::string::npos)
+			return (false);
+		std::string name = pair.substr(0, colon);
+		std::string levelName = pair.substr(colon + 1);
+		int level = 0;
+		while (level <= LEVEL_OFF && strcasecmp(levelName.c_str(), levelNames[level]) != 0)
+			level++;
+		if (level > LEVEL_OFF)
+			return (false);
+		int category = 0;
+		while (category < LOG_CATEGORIES && name != categoryNames[category])
+			category++;
+		if (name == "all")
+		{
+			for (int i = 0; i < LOG_CATEGORIES; i++)
+				setLevel(static_cast<logCategory>(i), static_cast<logLevel>(level));
+		}
+		else if (category < LOG_CATEGORIES)
+			setLevel(static_cast<logCategory>(category), static_cast<logLevel>(level));
+		else
+			return (false);
+		start = end + 1;
+	}
+	return (true);
+}
+
+/*Starts the writer thread. The slots are reset first, so start() must not race with write().*/
+void	Logger::start()
+{
+	if (_running.load())
+		return;
+	for (size_t i = 0; i < LOG_RING_SIZE; i++)
+		_records[i].sequence.store(i, std::memory_order_relaxed);
+	_tail.store(0);
+	_head = 0;
+	_running.store(true, std::memory_order_release);
+	_thread = std::thread(run);
+}
+
+/*Writes out the records which are left and stops the writer thread. Called once the event loops
+  stopped, later records are written directly.*/
+void	Logger::stop()
+{
+	if (!_running.exchange(false))
+		return;
+	_thread.join();
+	uint64_t dropped = _dropped.exchange(0);
+	if (dropped > 0)
+		LOG(LEVEL_WARN, LOG_CORE, dropped << " log record(s) dropped, the log ring was full");
+}
+
+uint64_t	Logger::getDropped() { return (_dropped.load(std::memory_order_relaxed)); }
+
+/*Writer thread: drains the ring, sleeps while it is empty and leaves once stop() was called and
+  everything is written*/
+void	Logger::run()
+{
+	while (true)
+	{
+		if (drain())
+			continue;
+		if (!_running.load(std::memory_order_acquire))
+		{
+			if (!drain())
+				break;
+			continue;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(LOG_IDLE_SLEEP_MS));
+	}
+}
+
+/*Formats the available records, one write per output and batch. Returns false if the ring was
+  empty.*/
+bool	Logger::drain()
+{
+	std::string	out;
+	std::string	errors;
+	size_t		count = 0;
+
+	while (count < LOG_RING_SIZE)
+	{
+		LogRecord &record = _records[_head & (LOG_RING_SIZE - 1)];
+		if (record.sequence.load(std::memory_order_acquire) != _head + 1)
+			break;
+		format(record.level >= LEVEL_WARN ? errors : out, record);
+		record.sequence.store(_head + LOG_RING_SIZE, std::memory_order_release);
+		_head++;
+		count++;
+	}
+	output(STDOUT_FILENO, out);
+	output(STDERR_FILENO, errors);
+	return (count > 0);
+}
+
+/*"2024-05-01 12:00:00.123 INFO  net: text"*/
+void	Logger::format(std::string &out, const LogRecord &record)
+{
+	time_t		seconds = record.timeMs / 1000;
+	struct tm	local;
+	char		prefix[64];
+
+	localtime_r(&seconds, &local);
+	size_t length = strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+	snprintf(prefix + length, sizeof(prefix) - length, ".%03u %-5s %s: ",
+		static_cast<unsigned>(record.timeMs % 1000), levelNames[record.level], categoryNames[record.category]);
+	out.append(prefix);
+	out.append(record.text, record.length);
+	out.push_back('\n');
+}
+
+void	Logger::output(int fd, std::string &out)
+{
+	size_t written = 0;
+
+	while (written < out.size())
+	{
+		ssize_t bytes = ::write(fd, out.data() + written, out.size() - written);
+		if (bytes == -1 && errno == EINTR)
+			continue;
+		if (bytes <= 0)
+			break;
+		written += bytes;
+	}
+	out.clear();
+}
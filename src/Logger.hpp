@@ -0,0 +1,106 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+enum logLevel
+{
+	LEVEL_TRACE,
+	LEVEL_DEBUG,
+	LEVEL_INFO,
+	LEVEL_WARN,
+	LEVEL_ERROR,
+	LEVEL_OFF
+};
+
+enum logCategory
+{
+	LOG_CORE,		// startup, shutdown, event backends
+	LOG_NET,		// connections
+	LOG_PROTO,		// every line received and sent
+	LOG_CHANNEL,
+	LOG_CLIENT,		// sessions and their commands
+	LOG_CATEGORIES
+};
+
+const size_t	LOG_RING_SIZE = 4096;		// records, a power of two
+const size_t	LOG_TEXT_SIZE = 232;		// longer messages are truncated
+const int		LOG_IDLE_SLEEP_MS = 10;
+
+/*Logs the stream expression message if level is enabled for the category. Disabled messages are
+  not formatted at all:
+	LOG(LEVEL_INFO, LOG_NET, "Accepted " << count << " connection(s)");*/
+#define LOG(level, category, message) \
+	do { \
+		if (Logger::isEnabled(level, category)) \
+		{ \
+			std::ostringstream logStream; \
+			logStream << message; \
+			Logger::write(level, category, logStream.str()); \
+		} \
+	} while (0)
+
+/*One slot of the ring. sequence tells whether the slot is free for the producer with the matching
+  position or holds a record for the consumer.*/
+struct LogRecord
+{
+	std::atomic<size_t>	sequence;
+	uint64_t			timeMs;				// CLOCK_REALTIME
+	uint8_t				level;
+	uint8_t				category;
+	uint16_t			length;
+	char				text[LOG_TEXT_SIZE];
+};
+
+/*Process wide leveled logger. Every category has a level of its own, by default INFO, so protocol
+  tracing (TRACE) is off. Records are copied into a bounded lock-free ring (multiple producers, one
+  consumer) and written to stdout (stderr for WARN and ERROR) by a background thread, the event
+  loops never wait for log I/O: if the ring is full the record is dropped and counted. Before
+  start() and after stop() records are written directly.*/
+class Logger
+{
+	public:
+		Logger() = delete;
+
+		static bool		isEnabled(logLevel level, logCategory category)
+		{
+			return (level >= _levels[category].load(std::memory_order_relaxed));
+		}
+		static void		write(logLevel level, logCategory category, const std::string &text);
+		static void		setLevel(logCategory category, logLevel level);
+		static bool		configure(const std::string &spec);
+		static void		start();
+		static void		stop();
+		static uint64_t	getDropped();
+
+	private:
+		static void		run();
+		static bool		drain();
+		static void		format(std::string &out, const LogRecord &record);
+		static void		output(int fd, std::string &out);
+
+		static inline std::atomic<int>		_levels[LOG_CATEGORIES] = {{LEVEL_INFO}, {LEVEL_INFO},
+			{LEVEL_INFO}, {LEVEL_INFO}, {LEVEL_INFO}};
+		static LogRecord					_records[LOG_RING_SIZE];
+		static std::atomic<size_t>			_tail;		// next position of the producers
+		static size_t						_head;		// next position of the consumer
+		static std::atomic<uint64_t>		_dropped;
+		static std::atomic<bool>			_running;
+		static std::thread					_thread;
+};
@@ -0,0 +1,166 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "LoopbackTransport.hpp"
+#include "Server.hpp"
+#include <arpa/inet.h>
+
+/* ************************************************Constructor Section START*************************************** */
+LoopbackTransport::LoopbackTransport(Server &server) : _server(server) {}
+
+/*Closes the clients which are left and lets the server release them, so no session refers to a
+  deleted client afterwards*/
+LoopbackTransport::~LoopbackTransport()
+{
+	for (Client *client : _clients)
+		closeClient(*client);
+	step();
+	for (Client *client : _clients)
+		delete client;
+}
+
+/* ************************************************Constructor Section END*************************************** */
+
+/*A new simulated connection from 127.0.0.1. It has no fd (-1). Returns nullptr if the server
+  is full (maxClients).*/
+Client	*LoopbackTransport::connect()
+{
+	sockaddr_in addr = {};
+
+	if (!_server.reserveConnection())
+		return (nullptr);
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	Client *client = new Client(-1, addr);
+	client->setState(REGISTERING);
+	client->setTransport(this);
+	_clients.insert(client);
+	_server.handleLoopMessage({LOOP_CONNECT, client, nullptr});
+	return (client);
+}
+
+/*Data sent by the client, as if read from its socket. Every complete line is handled before this
+  returns, an incomplete tail waits for the next call.*/
+void	LoopbackTransport::receive(Client &client, std::string_view data)
+{
+	RecvBuffer	&buffer = client.getRecvBuffer();
+	uint64_t	receivedAt = Metrics::monotonicMicros();
+	const char	*line;
+	size_t		length;
+	lineStatus	status;
+
+	while (!data.empty() && !client.isClosing() && client.getState() != DISCONNECTED)
+	{
+		data.remove_prefix(buffer.append(data.data(), data.size()));
+		while ((status = buffer.nextLine(line, length)) != LINE_NONE)
+		{
+			if (status == LINE_TOO_LONG)
+				_server.inputTooLong(client);
+			else
+				_server.handleClientMessage(client, std::string_view(line, length), receivedAt);
+			if (client.getState() == DISCONNECTED || client.isClosing())
+				return;
+		}
+	}
+}
+
+/*Appends everything queued for the client to out and empties its send queue, as if the socket
+  had been written. Returns the amount of bytes.*/
+size_t	LoopbackTransport::takeOutput(Client &client, std::string &out)
+{
+	SendQueue		&queue = client.getSendQueue();
+	struct iovec	iov[SENDQ_IOV_BATCH];
+	size_t			taken = 0;
+
+	while (!queue.empty())
+	{
+		int count = queue.prepare(iov, SENDQ_IOV_BATCH);
+		size_t bytes = 0;
+		for (int i = 0; i < count; i++)
+		{
+			out.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+			bytes += iov[i].iov_len;
+		}
+		queue.consume(bytes);
+		taken += bytes;
+	}
+	return (taken);
+}
+
+/*The client closes the connection*/
+void	LoopbackTransport::disconnect(Client &client)
+{
+	if (client.isClosing())
+		return;
+	_server.getMetrics().disconnected(DISCONNECT_PEER_CLOSED);
+	closeClient(client);
+}
+
+/*End of a main loop iteration, in the order of EventLoop::runOnce: the sessions marked by
+  disconnectClient are removed, the connections asked for are closed and the closed clients
+  released (deleted)*/
+void	LoopbackTransport::step()
+{
+	_server.reapClients();
+	reapClients();
+	_server.recordLatencies();
+	_server.reapClients();
+}
+
+/*Amount of clients not released yet*/
+size_t	LoopbackTransport::getClientCount() const { return (_clients.size()); }
+
+void	LoopbackTransport::postFromMain(const LoopMessage &message)
+{
+	if (message.type == LOOP_SEND)
+		queueLine(*message.client, message.line);
+	else if (message.type == LOOP_CLOSE)
+		closeClient(*message.client);
+	else if (message.type == LOOP_RELEASE)
+	{
+		_clients.erase(message.client);
+		delete message.client;
+	}
+}
+
+/*Like EventLoop::queueLine, a client whose send queue overflows is closed*/
+void	LoopbackTransport::queueLine(Client &client, const SharedLine &line)
+{
+	if (client.isClosing())
+		return;
+	if (!client.getSendQueue().push(line))
+	{
+		_server.getMetrics().disconnected(DISCONNECT_SENDQ_EXCEEDED);
+		closeClient(client);
+	}
+}
+
+void	LoopbackTransport::closeClient(Client &client)
+{
+	if (client.isClosing())
+		return;
+	client.setClosing(true);
+	_pendingClose.push_back(&client);
+}
+
+/*The closed connections are reported to the main loop, which answers with RELEASE once the
+  session is removed*/
+void	LoopbackTransport::reapClients()
+{
+	for (Client *client : _pendingClose)
+	{
+		client->getSendQueue().clear();
+		_server.releaseConnection();
+		_server.handleLoopMessage({LOOP_DISCONNECT, client, nullptr});
+	}
+	_pendingClose.clear();
+}
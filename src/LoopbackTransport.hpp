@@ -0,0 +1,58 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include "Client.hpp"
+#include "Transport.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+class Server;
+
+/*Memory backed transport for simulated clients. They take the same path through the main loop as
+  real connections (CONNECT, the handlers, SEND, CLOSE, DISCONNECT and RELEASE), only the socket is
+  replaced: input is framed into lines by the client's receive buffer and handled right away,
+  replies collect in its send queue until they are taken with takeOutput().
+
+  Nothing happens in the background, the caller drives the main loop with step() (the end of an
+  event loop iteration: closes the connections asked for and releases the sessions), so a scenario
+  runs the same way every time. Timers are not run, call Server::runTimers() to have them. A client
+  is deleted by the step() after it was closed, its output has to be taken before. Meant for a
+  Server which is not running (runServer), everything happens on the calling thread.*/
+class LoopbackTransport : public Transport
+{
+	public:
+		LoopbackTransport(Server &server);
+		LoopbackTransport(const LoopbackTransport &other) = delete;
+		LoopbackTransport &operator=(const LoopbackTransport &other) = delete;
+		~LoopbackTransport();
+
+		Client	*connect();
+		void	receive(Client &client, std::string_view data);
+		size_t	takeOutput(Client &client, std::string &out);
+		void	disconnect(Client &client);
+		void	step();
+		size_t	getClientCount() const;
+		void	postFromMain(const LoopMessage &message) override;
+
+	private:
+		void	queueLine(Client &client, const SharedLine &line);
+		void	closeClient(Client &client);
+		void	reapClients();
+
+		Server						&_server;
+		std::unordered_set<Client *>	_clients;		// connected or closed, until RELEASE
+		std::vector<Client *>		_pendingClose;
+};
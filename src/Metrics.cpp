@@ -0,0 +1,140 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Metrics.hpp"
+#include "TimerWheel.hpp"
+#include <algorithm>
+#include <ctime>
+
+static const char	*reasonNames[] = {"peer_closed", "read_error", "write_error", "sendq_exceeded",
+	"bad_password", "registration_failed", "registration_timeout", "ping_timeout", "quit"};
+
+/* ************************************************Constructor Section START*************************************** */
+LatencyHistogram::LatencyHistogram() : _count(0), _sum(0), _max(0)
+{
+	for (int i = 0; i < LATENCY_BUCKETS; i++)
+		_buckets[i].store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogram::~LatencyHistogram() {}
+
+Metrics::Metrics() : _broadcasts(0), _fanout(0), _startedAt(TimerWheel::monotonicMs())
+{
+	for (int i = 0; i < METRICS_COMMANDS; i++)
+		_commands[i].store(0, std::memory_order_relaxed);
+	for (int i = 0; i < DISCONNECT_REASONS; i++)
+		_disconnects[i].store(0, std::memory_order_relaxed);
+}
+
+Metrics::~Metrics() {}
+
+/* ************************************************Constructor Section END*************************************** */
+
+/*Values below 2 * LATENCY_SUB_BUCKETS are their own bucket. Larger ones drop their low bits until
+  LATENCY_SUB_BUCKET_BITS + 1 bits are left, the dropped amount selects the power of two.*/
+int	LatencyHistogram::bucketIndex(uint64_t value)
+{
+	if (value >= (1ULL << LATENCY_MAX_BITS))
+		value = (1ULL << LATENCY_MAX_BITS) - 1;
+	if (value < 2 * LATENCY_SUB_BUCKETS)
+		return (static_cast<int>(value));
+	int shift = (64 - __builtin_clzll(value)) - LATENCY_SUB_BUCKET_BITS - 1;
+	return (shift * LATENCY_SUB_BUCKETS + static_cast<int>(value >> shift));
+}
+
+/*Highest value counted in the bucket*/
+uint64_t	LatencyHistogram::bucketHighest(int index)
+{
+	if (index < 2 * LATENCY_SUB_BUCKETS)
+		return (index);
+	int shift = index / LATENCY_SUB_BUCKETS - 1;
+	uint64_t lowest = static_cast<uint64_t>(index - shift * LATENCY_SUB_BUCKETS) << shift;
+	return (lowest + (1ULL << shift) - 1);
+}
+
+void	LatencyHistogram::record(uint64_t micros)
+{
+	addCounter(_buckets[bucketIndex(micros)], 1);
+	addCounter(_count, 1);
+	addCounter(_sum, micros);
+	if (micros > _max.load(std::memory_order_relaxed))
+		_max.store(micros, std::memory_order_relaxed);
+}
+
+uint64_t	LatencyHistogram::getCount() const { return (_count.load(std::memory_order_relaxed)); }
+
+uint64_t	LatencyHistogram::getSum() const { return (_sum.load(std::memory_order_relaxed)); }
+
+uint64_t	LatencyHistogram::getMax() const { return (_max.load(std::memory_order_relaxed)); }
+
+/*Value below which percentile (0 - 100) percent of the recorded values are, rounded up to the end
+  of its bucket (at most the maximum). 0 without values.*/
+uint64_t	LatencyHistogram::getPercentile(double percentile) const
+{
+	uint64_t count = getCount();
+	if (count == 0)
+		return (0);
+	uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+	if (rank < 1)
+		rank = 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		seen += _buckets[i].load(std::memory_order_relaxed);
+		if (seen >= rank)
+			return (std::min(bucketHighest(i), getMax()));
+	}
+	return (getMax());
+}
+
+/*Index is the position in the command table, MAX_COMMANDS for unknown commands*/
+void	Metrics::commandHandled(int index) { addCounter(_commands[index], 1); }
+
+/*A line sent to the members of a channel*/
+void	Metrics::broadcast(size_t recipients)
+{
+	addCounter(_broadcasts, 1);
+	addCounter(_fanout, recipients);
+}
+
+void	Metrics::disconnected(disconnectReason reason)
+{
+	_disconnects[reason].fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyHistogram	&Metrics::getLatency(int index) { return (_latency[index]); }
+
+const LatencyHistogram	&Metrics::getLatency(int index) const { return (_latency[index]); }
+
+uint64_t	Metrics::getCommands(int index) const { return (_commands[index].load(std::memory_order_relaxed)); }
+
+uint64_t	Metrics::getBroadcasts() const { return (_broadcasts.load(std::memory_order_relaxed)); }
+
+uint64_t	Metrics::getFanout() const { return (_fanout.load(std::memory_order_relaxed)); }
+
+uint64_t	Metrics::getDisconnects(disconnectReason reason) const
+{
+	return (_disconnects[reason].load(std::memory_order_relaxed));
+}
+
+uint64_t	Metrics::getStartedAt() const { return (_startedAt); }
+
+const char	*Metrics::getReasonName(disconnectReason reason) { return (reasonNames[reason]); }
+
+/*Microseconds of the monotonic clock, timestamps of received lines*/
+uint64_t	Metrics::monotonicMicros()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000);
+}
@@ -0,0 +1,115 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include "CommandTable.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+const int	LATENCY_SUB_BUCKET_BITS = 4;		// 16 buckets per power of two, < 6.25% error
+const int	LATENCY_SUB_BUCKETS = 1 << LATENCY_SUB_BUCKET_BITS;
+const int	LATENCY_MAX_BITS = 32;				// values up to 2^32 - 1 microseconds
+const int	LATENCY_BUCKETS = (LATENCY_MAX_BITS - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS;
+const int	METRICS_COMMANDS = MAX_COMMANDS + 1;	// the last one counts unknown commands
+
+enum disconnectReason
+{
+	DISCONNECT_PEER_CLOSED,
+	DISCONNECT_READ_ERROR,
+	DISCONNECT_WRITE_ERROR,
+	DISCONNECT_SENDQ_EXCEEDED,
+	DISCONNECT_BAD_PASSWORD,
+	DISCONNECT_REGISTRATION_FAILED,
+	DISCONNECT_REGISTRATION_TIMEOUT,
+	DISCONNECT_PING_TIMEOUT,
+	DISCONNECT_QUIT,
+	DISCONNECT_REASONS
+};
+
+/*Adds to a counter which only one thread writes, without a locked instruction. Other threads may
+  read it at any time.*/
+inline void	addCounter(std::atomic<uint64_t> &counter, uint64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/*Log-linear (HDR style) histogram of microsecond values: values below 2 * LATENCY_SUB_BUCKETS are
+  counted exactly, every further power of two is split into LATENCY_SUB_BUCKETS buckets, so the
+  relative error stays below 1 / LATENCY_SUB_BUCKETS over the whole range. Written by one thread,
+  readable by any.*/
+class LatencyHistogram
+{
+	public:
+		LatencyHistogram();
+		LatencyHistogram(const LatencyHistogram &other) = delete;
+		LatencyHistogram &operator=(const LatencyHistogram &other) = delete;
+		~LatencyHistogram();
+
+		void		record(uint64_t micros);
+		uint64_t	getCount() const;
+		uint64_t	getSum() const;
+		uint64_t	getMax() const;
+		uint64_t	getPercentile(double percentile) const;
+
+		static int		bucketIndex(uint64_t value);
+		static uint64_t	bucketHighest(int index);
+
+	private:
+		std::atomic<uint64_t>	_buckets[LATENCY_BUCKETS];
+		std::atomic<uint64_t>	_count;
+		std::atomic<uint64_t>	_sum;
+		std::atomic<uint64_t>	_max;
+};
+
+/*Counters of one event loop, written only by the loop's thread*/
+struct LoopStats
+{
+	std::atomic<uint64_t>	bytesIn{0};
+	std::atomic<uint64_t>	bytesOut{0};
+	std::atomic<uint64_t>	queuedBytes{0};		// in all send queues of the loop
+	std::atomic<uint64_t>	queuePeak{0};		// largest send queue of a single client
+};
+
+/*Server wide counters, mostly written by the main loop. Disconnect reasons are also counted by
+  the other event loops. Everything can be read from any thread (STATS, admin endpoint).*/
+class Metrics
+{
+	public:
+		Metrics();
+		Metrics(const Metrics &other) = delete;
+		Metrics &operator=(const Metrics &other) = delete;
+		~Metrics();
+
+		void				commandHandled(int index);
+		void				broadcast(size_t recipients);
+		void				disconnected(disconnectReason reason);
+		LatencyHistogram	&getLatency(int index);
+		const LatencyHistogram	&getLatency(int index) const;
+		uint64_t			getCommands(int index) const;
+		uint64_t			getBroadcasts() const;
+		uint64_t			getFanout() const;
+		uint64_t			getDisconnects(disconnectReason reason) const;
+		uint64_t			getStartedAt() const;
+
+		static const char	*getReasonName(disconnectReason reason);
+		static uint64_t		monotonicMicros();
+
+	private:
+		std::atomic<uint64_t>	_commands[METRICS_COMMANDS];
+		std::atomic<uint64_t>	_broadcasts;
+		std::atomic<uint64_t>	_fanout;
+		std::atomic<uint64_t>	_disconnects[DISCONNECT_REASONS];
+		LatencyHistogram		_latency[METRICS_COMMANDS];
+		uint64_t				_startedAt;		// monotonic ms
+};
@@ -0,0 +1,176 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Poller.hpp"
+#include "Logger.hpp"
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+const int EPOLL_BATCH_SIZE = 256;
+
+Poller::~Poller() {}
+
+/*Returns the requested backend. If epoll is requested but not available on the system,
+  falls back to the poll() backend.*/
+Poller	*Poller::create(const std::string &backend)
+{
+	if (backend == "poll")
+		return (new PollPoller());
+	try {
+		return (new EpollPoller());
+	}
+	catch (const std::system_error &e) {
+		LOG(LEVEL_WARN, LOG_CORE, e.what() << ", falling back to poll()");
+		return (new PollPoller());
+	}
+}
+
+/* ************************************************EpollPoller START*************************************** */
+
+static uint32_t	toEpollEvents(unsigned events)
+{
+	uint32_t	result = 0;
+
+	if (events & POLLER_READ)
+		result |= EPOLLIN;
+	if (events & POLLER_WRITE)
+		result |= EPOLLOUT;
+	return (result);
+}
+
+EpollPoller::EpollPoller()
+{
+	_epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (_epollFd == -1)
+		throw std::system_error(errno, std::generic_category(), "epoll_create1 failed");
+}
+
+EpollPoller::~EpollPoller() { close(_epollFd); }
+
+void	EpollPoller::add(int fd, unsigned events)
+{
+	struct epoll_event	ev = {};
+
+	ev.events = toEpollEvents(events);
+	ev.data.fd = fd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) == -1)
+		throw std::system_error(errno, std::generic_category(), "epoll_ctl ADD failed");
+}
+
+void	EpollPoller::modify(int fd, unsigned events)
+{
+	struct epoll_event	ev = {};
+
+	ev.events = toEpollEvents(events);
+	ev.data.fd = fd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) == -1)
+		LOG(LEVEL_ERROR, LOG_NET, "epoll_ctl MOD failed: " << std::strerror(errno));
+}
+
+/*Fd has to be removed before it is closed. If the kernel already dropped it,
+  EPOLL_CTL_DEL fails with EBADF, which is harmless.*/
+void	EpollPoller::remove(int fd)
+{
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int	EpollPoller::wait(std::vector<PollerEvent> &ready, int timeoutMs)
+{
+	struct epoll_event	events[EPOLL_BATCH_SIZE];
+
+	ready.clear();
+	int n = epoll_wait(_epollFd, events, EPOLL_BATCH_SIZE, timeoutMs);
+	if (n <= 0)
+		return (n);
+	for (int i = 0; i < n; i++) {
+		unsigned	flags = 0;
+		if (events[i].events & (EPOLLIN | EPOLLHUP))
+			flags |= POLLER_READ;
+		if (events[i].events & EPOLLOUT)
+			flags |= POLLER_WRITE;
+		if (events[i].events & EPOLLERR)
+			flags |= POLLER_ERROR;
+		ready.push_back({events[i].data.fd, flags});
+	}
+	return (n);
+}
+
+const char	*EpollPoller::getName() const { return ("epoll"); }
+
+/* ************************************************PollPoller START*************************************** */
+
+static short	toPollEvents(unsigned events)
+{
+	short	result = 0;
+
+	if (events & POLLER_READ)
+		result |= POLLIN;
+	if (events & POLLER_WRITE)
+		result |= POLLOUT;
+	return (result);
+}
+
+PollPoller::PollPoller() {}
+
+PollPoller::~PollPoller() {}
+
+void	PollPoller::add(int fd, unsigned events)
+{
+	if (static_cast<size_t>(fd) >= _slots.size())
+		_slots.resize(fd + 1, -1);
+	_slots[fd] = _fds.size();
+	_fds.push_back({fd, toPollEvents(events), 0});
+}
+
+void	PollPoller::modify(int fd, unsigned events)
+{
+	if (static_cast<size_t>(fd) < _slots.size() && _slots[fd] != -1)
+		_fds[_slots[fd]].events = toPollEvents(events);
+}
+
+/*Swaps the last pollfd into the freed slot so the array stays dense*/
+void	PollPoller::remove(int fd)
+{
+	if (static_cast<size_t>(fd) >= _slots.size() || _slots[fd] == -1)
+		return;
+	int	slot = _slots[fd];
+	_fds[slot] = _fds.back();
+	_slots[_fds[slot].fd] = slot;
+	_fds.pop_back();
+	_slots[fd] = -1;
+}
+
+int	PollPoller::wait(std::vector<PollerEvent> &ready, int timeoutMs)
+{
+	ready.clear();
+	int n = poll(_fds.data(), _fds.size(), timeoutMs);
+	if (n <= 0)
+		return (n);
+	for (const struct pollfd &pfd : _fds) {
+		if (pfd.revents == 0)
+			continue;
+		unsigned	flags = 0;
+		if (pfd.revents & (POLLIN | POLLHUP))
+			flags |= POLLER_READ;
+		if (pfd.revents & POLLOUT)
+			flags |= POLLER_WRITE;
+		if (pfd.revents & (POLLERR | POLLNVAL))
+			flags |= POLLER_ERROR;
+		ready.push_back({pfd.fd, flags});
+	}
+	return (n);
+}
+
+const char	*PollPoller::getName() const { return ("poll"); }
@@ -0,0 +1,88 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <poll.h>
+
+/*Interest / readiness flags used by all poller backends*/
+enum pollerFlags
+{
+	POLLER_READ = 1,
+	POLLER_WRITE = 2,
+	POLLER_ERROR = 4
+};
+
+struct PollerEvent
+{
+	int			fd;
+	unsigned	events;
+};
+
+/*Common interface of the event notification backends. File descriptors are registered once
+  (add), their interest set can be changed (modify) and they are unregistered on disconnect
+  (remove). wait() only reports the fds which are actually ready.*/
+class Poller
+{
+	public:
+		virtual ~Poller();
+
+		virtual void		add(int fd, unsigned events) = 0;
+		virtual void		modify(int fd, unsigned events) = 0;
+		virtual void		remove(int fd) = 0;
+		virtual int			wait(std::vector<PollerEvent> &ready, int timeoutMs) = 0;
+		virtual const char	*getName() const = 0;
+
+		static Poller		*create(const std::string &backend);
+};
+
+/*Linux epoll backend, cost of wait() only depends on the amount of ready fds*/
+class EpollPoller : public Poller
+{
+	public:
+		EpollPoller();
+		EpollPoller(const EpollPoller &other) = delete;
+		EpollPoller &operator=(const EpollPoller &other) = delete;
+		~EpollPoller();
+
+		void		add(int fd, unsigned events) override;
+		void		modify(int fd, unsigned events) override;
+		void		remove(int fd) override;
+		int			wait(std::vector<PollerEvent> &ready, int timeoutMs) override;
+		const char	*getName() const override;
+
+	private:
+		int			_epollFd;
+};
+
+/*Portable poll() backend. The pollfd array is kept between calls and updated in place,
+  _slots maps a fd to its position in the array.*/
+class PollPoller : public Poller
+{
+	public:
+		PollPoller();
+		PollPoller(const PollPoller &other) = delete;
+		PollPoller &operator=(const PollPoller &other) = delete;
+		~PollPoller();
+
+		void		add(int fd, unsigned events) override;
+		void		modify(int fd, unsigned events) override;
+		void		remove(int fd) override;
+		int			wait(std::vector<PollerEvent> &ready, int timeoutMs) override;
+		const char	*getName() const override;
+
+	private:
+		std::vector<struct pollfd>	_fds;
+		std::vector<int>			_slots;
+};
@@ -0,0 +1,130 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "RecvBuffer.hpp"
+#include <sys/socket.h>
+#include <cstring>
+#include <algorithm>
+
+/* ************************************************Constructor Section START*************************************** */
+RecvBuffer::RecvBuffer() : _data(RECV_BUFFER_SIZE), _start(0), _end(0), _scan(0), _discarding(false) {}
+
+RecvBuffer::RecvBuffer(const RecvBuffer &other)
+{
+	this->_data = other._data;
+	this->_start = other._start;
+	this->_end = other._end;
+	this->_scan = other._scan;
+	this->_discarding = other._discarding;
+}
+
+RecvBuffer &RecvBuffer::operator=(const RecvBuffer &other)
+{
+	if (this != &other)
+	{
+		this->_data = other._data;
+		this->_start = other._start;
+		this->_end = other._end;
+		this->_scan = other._scan;
+		this->_discarding = other._discarding;
+	}
+	return *this;
+}
+
+RecvBuffer::~RecvBuffer() {}
+
+/* ************************************************Constructor Section END*************************************** */
+
+/*Moves the incomplete tail of the previous read (at most MAX_LINE_LENGTH bytes once nextLine()
+  returned LINE_NONE) to the front of the buffer*/
+void	RecvBuffer::compact()
+{
+	if (_start == _end)
+		_start = _end = _scan = 0;
+	else if (_start > 0)
+	{
+		std::memmove(_data.data(), _data.data() + _start, _end - _start);
+		_end -= _start;
+		_scan -= _start;
+		_start = 0;
+	}
+}
+
+/*Reads as much as fits into the free part of the buffer. drained is set if the read did not fill
+  the buffer, which means the socket has nothing more to read.*/
+ssize_t	RecvBuffer::readFrom(int fd, bool &drained)
+{
+	compact();
+	size_t space = _data.size() - _end;
+	ssize_t bytes = recv(fd, _data.data() + _end, space, 0);
+	if (bytes > 0)
+		_end += bytes;
+	drained = (bytes < static_cast<ssize_t>(space));
+	return (bytes);
+}
+
+/*Copies data which was already received (io_uring backend) into the free part of the buffer.
+  Returns the amount of bytes copied, the rest has to be appended after the buffered lines were
+  taken out with nextLine().*/
+size_t	RecvBuffer::append(const char *data, size_t length)
+{
+	compact();
+	size_t bytes = std::min(length, _data.size() - _end);
+	std::memcpy(_data.data() + _end, data, bytes);
+	_end += bytes;
+	return (bytes);
+}
+
+/*Looks for the next \n terminated line in the buffered data. On LINE_OK, line and length
+  describe the line without its \r\n, the pointer stays valid until the next readFrom or append
+  call. Empty lines are skipped. If more than MAX_LINE_LENGTH bytes are pending without a line end,
+  they are dropped together with the rest of that line and LINE_TOO_LONG is reported once.*/
+lineStatus	RecvBuffer::nextLine(const char *&line, size_t &length)
+{
+	const char	*base = _data.data();
+
+	while (true)
+	{
+		const void *newline = std::memchr(base + _scan, '\n', _end - _scan);
+		if (newline == nullptr)
+		{
+			_scan = _end;
+			if (_discarding)
+				_start = _end;
+			else if (_end - _start >= MAX_LINE_LENGTH)
+			{
+				_discarding = true;
+				_start = _end;
+				return (LINE_TOO_LONG);
+			}
+			return (LINE_NONE);
+		}
+		size_t lineEnd = static_cast<const char *>(newline) - base;
+		size_t lineStart = _start;
+		_start = _scan = lineEnd + 1;
+		if (_discarding)
+		{
+			_discarding = false;
+			continue;
+		}
+		if (lineEnd + 1 - lineStart > MAX_LINE_LENGTH)
+			return (LINE_TOO_LONG);
+		size_t lineLength = lineEnd - lineStart;
+		if (lineLength > 0 && base[lineEnd - 1] == '\r')
+			lineLength--;
+		if (lineLength == 0)
+			continue;
+		line = base + lineStart;
+		length = lineLength;
+		return (LINE_OK);
+	}
+}
@@ -0,0 +1,53 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <vector>
+#include <sys/types.h>
+
+const size_t	RECV_BUFFER_SIZE = 4096;
+const size_t	MAX_LINE_LENGTH = 512;
+const size_t	MAX_NICK_LENGTH = 30;		// NICKLEN, longer nicks are refused by NICK
+
+enum lineStatus
+{
+	LINE_NONE,
+	LINE_OK,
+	LINE_TOO_LONG
+};
+
+/*Receive buffer of one client connection. The storage is allocated once and reused for every
+  read. nextLine() hands out complete lines as pointer + length into the buffer, an incomplete
+  tail stays in the buffer until the rest of the line arrives. Lines longer than MAX_LINE_LENGTH
+  (including the line terminator) are discarded.*/
+class RecvBuffer
+{
+	public:
+		RecvBuffer();
+		RecvBuffer(const RecvBuffer &other);
+		RecvBuffer &operator=(const RecvBuffer &other);
+		~RecvBuffer();
+
+		ssize_t		readFrom(int fd, bool &drained);
+		size_t		append(const char *data, size_t length);
+		lineStatus	nextLine(const char *&line, size_t &length);
+
+	private:
+		void		compact();
+
+		std::vector<char>	_data;
+		size_t				_start;
+		size_t				_end;
+		size_t				_scan;
+		bool				_discarding;
+};
@@ -0,0 +1,105 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+
+#pragma once
+
+#include "SendQueue.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+
+const size_t	REPLY_RESERVE = 128;	// numerics and most relayed lines fit, see Reply
+const char		SERVER_NAME[] = "localhost";	// source of the lines the server sends on its own behalf
+
+/*One outgoing protocol line built in place. Every piece is appended to one buffer, and line()
+  terminates it with \r\n and hands that buffer over as the SharedLine the send queues write from,
+  nothing is copied on the way. A reply of up to REPLY_RESERVE bytes costs two allocations, the
+  buffer and the shared line. The buffer stays queued with its capacity, so it is reserved for a
+  typical reply rather than a full line, longer lines grow it to at most twice their size. After
+  line() the reply is complete, further calls return the same line (one reply may be queued for
+  several clients).
+
+	Reply::server("401").param(nick).param(target).trailing("No such nick/channel")
+	Reply(client.getPrefix()).param("PRIVMSG").param(channel).trailing(text)
+
+  The appends are defined here so they are inlined into the reply macros of response.hpp.*/
+class Reply
+{
+	public:
+		explicit Reply(std::string_view command)
+		{
+			_buffer.reserve(REPLY_RESERVE);
+			_buffer.append(command);
+		}
+
+		/*Line with the server (or another plain name) as source, ":source command"*/
+		static Reply	from(std::string_view source, std::string_view command)
+		{
+			Reply reply(":");
+
+			reply._buffer.append(source).append(1, ' ').append(command);
+			return (reply);
+		}
+
+		/*Numerics and other lines of the server itself, ":SERVER_NAME command"*/
+		static Reply	server(std::string_view command) { return (from(SERVER_NAME, command)); }
+
+		/*" value", also used for parameters which are lists themselves (e.g. mode arguments)*/
+		Reply	&param(std::string_view value)
+		{
+			_buffer.append(1, ' ').append(value);
+			return (*this);
+		}
+
+		Reply	&param(char value)
+		{
+			_buffer.append(1, ' ').append(1, value);
+			return (*this);
+		}
+
+		/*" :value", the last parameter which may contain spaces*/
+		Reply	&trailing(std::string_view value)
+		{
+			_buffer.append(" :", 2).append(value);
+			return (*this);
+		}
+
+		/*Appends to the last piece without a separator*/
+		Reply	&append(std::string_view value)
+		{
+			_buffer.append(value);
+			return (*this);
+		}
+
+		/*The line without \r\n, for logging*/
+		std::string_view	view() const
+		{
+			if (_line)
+				return (std::string_view(*_line).substr(0, _line->size() - 2));
+			return (_buffer);
+		}
+
+		const SharedLine	&line()
+		{
+			if (!_line)
+			{
+				_buffer.append("\r\n", 2);
+				_line = std::make_shared<const std::string>(std::move(_buffer));
+			}
+			return (_line);
+		}
+
+	private:
+		std::string	_buffer;
+		SharedLine	_line;
+};
@@ -0,0 +1,116 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "SendQueue.hpp"
+#include <cerrno>
+
+/* ************************************************Constructor Section START*************************************** */
+SendQueue::SendQueue() : _offset(0), _bytes(0) {}
+
+SendQueue::SendQueue(const SendQueue &other)
+{
+	this->_lines = other._lines;
+	this->_offset = other._offset;
+	this->_bytes = other._bytes;
+}
+
+SendQueue &SendQueue::operator=(const SendQueue &other)
+{
+	if (this != &other)
+	{
+		this->_lines = other._lines;
+		this->_offset = other._offset;
+		this->_bytes = other._bytes;
+	}
+	return *this;
+}
+
+SendQueue::~SendQueue() {}
+
+/* ************************************************Constructor Section END*************************************** */
+
+/*Appends a complete line (including \r\n) to the queue. Returns false without queueing if the
+  line would exceed SENDQ_LIMIT, the caller is then expected to drop the client.*/
+bool	SendQueue::push(const SharedLine &line)
+{
+	if (_bytes + line->size() > SENDQ_LIMIT)
+		return (false);
+	_lines.push_back(line);
+	_bytes += line->size();
+	return (true);
+}
+
+/*Writes queued lines to the non-blocking socket, up to SENDQ_IOV_BATCH lines per writev call.
+  Partially written lines are remembered with _offset. Returns FLUSH_AGAIN if the socket buffer
+  is full and data is left, FLUSH_DONE if the queue is empty and FLUSH_ERROR on a socket error.*/
+flushResult	SendQueue::flush(int fd)
+{
+	struct iovec	iov[SENDQ_IOV_BATCH];
+
+	while (!_lines.empty())
+	{
+		int count = prepare(iov, SENDQ_IOV_BATCH);
+		ssize_t written = writev(fd, iov, count);
+		if (written == -1)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return (FLUSH_AGAIN);
+			if (errno == EINTR)
+				continue;
+			return (FLUSH_ERROR);
+		}
+		consume(written);
+	}
+	return (FLUSH_DONE);
+}
+
+/*Describes up to max queued lines from the front of the queue in iov (the first one without its
+  already written part) and returns the amount of entries used. If hold is given, the lines are
+  also copied into it, so their buffers stay alive while an asynchronous send refers to them.*/
+int	SendQueue::prepare(struct iovec *iov, int max, std::vector<SharedLine> *hold) const
+{
+	int	count = 0;
+
+	for (auto it = _lines.begin(); it != _lines.end() && count < max; ++it, ++count)
+	{
+		size_t skip = (count == 0) ? _offset : 0;
+		iov[count].iov_base = const_cast<char *>((*it)->data() + skip);
+		iov[count].iov_len = (*it)->size() - skip;
+		if (hold != nullptr)
+			hold->push_back(*it);
+	}
+	return (count);
+}
+
+/*Removes bytes written to the socket from the front of the queue*/
+void	SendQueue::consume(size_t bytes)
+{
+	_bytes -= bytes;
+	size_t left = bytes + _offset;
+	while (!_lines.empty() && left >= _lines.front()->size())
+	{
+		left -= _lines.front()->size();
+		_lines.pop_front();
+	}
+	_offset = left;
+}
+
+bool	SendQueue::empty() const { return (_lines.empty()); }
+
+size_t	SendQueue::getBytes() const { return (_bytes); }
+
+void	SendQueue::clear()
+{
+	_lines.clear();
+	_offset = 0;
+	_bytes = 0;
+}
@@ -0,0 +1,59 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+const size_t	SENDQ_LIMIT = 512 * 1024;
+const int		SENDQ_IOV_BATCH = 64;
+
+/*Immutable, reference counted line (including \r\n). A broadcast is formatted once and the
+  same buffer is queued for every recipient.*/
+typedef std::shared_ptr<const std::string>	SharedLine;
+
+enum flushResult
+{
+	FLUSH_DONE,
+	FLUSH_AGAIN,
+	FLUSH_ERROR
+};
+
+/*Outgoing messages of one client which could not be written to the socket yet. Bounded by
+  SENDQ_LIMIT bytes, flush() writes as much as the socket accepts and coalesces the queued
+  lines into a single writev call. Lines are shared with the queues of other clients.*/
+class SendQueue
+{
+	public:
+		SendQueue();
+		SendQueue(const SendQueue &other);
+		SendQueue &operator=(const SendQueue &other);
+		~SendQueue();
+
+		bool		push(const SharedLine &line);
+		flushResult	flush(int fd);
+		int			prepare(struct iovec *iov, int max, std::vector<SharedLine> *hold = nullptr) const;
+		void		consume(size_t bytes);
+		bool		empty() const;
+		size_t		getBytes() const;
+		void		clear();
+
+	private:
+		std::deque<SharedLine>	_lines;
+		size_t					_offset;
+		size_t					_bytes;
+};
@@ -13,22 +13,29 @@
 #include "Server.hpp"
 #include "response.hpp"
 
-Server::Server() {}
+Server::Server() : _connections(0), _admin(nullptr), _capture(nullptr), _lastClientId(0), _broadcastEpoch(0) {}
 
 Server::Server(int _port, std::string _passwd) :
 	_port(_port),
-	_passwd(_passwd)
+	_passwd(_passwd),
+	_connections(0),
+	_admin(nullptr),
+	_capture(nullptr),
+	_lastClientId(0),
+	_broadcastEpoch(0)
 	{}
 
-Server::Server(const Server& other) {
+Server::Server(const Server& other) : _connections(0), _admin(nullptr), _capture(nullptr), _lastClientId(0), _broadcastEpoch(0) {
 	this->_port = other._port;
 	this->_passwd = other._passwd;
+	this->_config = other._config;
 }
 
 Server& Server::operator=(const Server& other) {
 	if (this != &other) {
 		this->_port = other._port;
 		this->_passwd = other._passwd;
+		this->_config = other._config;
 	}
 	return *this;
 }
@@ -51,36 +58,24 @@ std::string Server::getPassword() const {
 	return _passwd;
 }
 
-void Server::addClient(Client* client) {
-	_clients.push_back(client);
+void Server::setConfig(const ServerConfig &config) {
+	_config = config;
 }
 
-void Server::removeClient(int fd) {
-	for (auto it = _clients.begin(); it != _clients.end(); ++it) {
-		if ((*it)->getFd() == fd) {
-			delete *it;
-			_clients.erase(it);
-			break;
-		}
-	}
+const ServerConfig &Server::getConfig() const {
+	return _config;
 }
 
-bool Server::checkIfChannelExists(const std::string& channelName) {
-    for (Channel* channel : _channels) {
-        if (channel->getChannelName() == channelName) {
-            return true; 
-        }
-    }
-    return false;
+/*Removes the client from the member and operator lists of every channel it joined, channels
+  which become empty are destroyed*/
+void Server::removeFromAllChannels(Client *client) {
+	const std::unordered_set<Channel *> &joined = client->getJoinedChannels();
+	while (!joined.empty())
+		removeClientFromChannel(*joined.begin(), client);
 }
 
-bool Server::clientExists(const std::string& nick){
-	for (Client* client : _clients)
-	{
-		if (client->getNick() == nick)
-			return true;
-	}
-	return false;
+bool Server::clientExists(std::string_view nick){
+	return (getClientByNickname(nick) != nullptr);
 }
 
 
@@ -14,13 +14,27 @@
 
 #include "Client.hpp"
 #include "Channel.hpp"
+#include "Config.hpp"
+#include "EventLoop.hpp"
+#include "TimerWheel.hpp"
+#include "IrcMessage.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "AdminEndpoint.hpp"
+#include "CommandTable.hpp"
+#include "TrafficCapture.hpp"
+#include "Reply.hpp"
 #include <vector>
+#include <unordered_map>
 #include <signal.h>
 #include <iostream>
 
 
-const int BUFFER_SIZE = 1024;
-const int MAX_CLIENTS = 999;
+const int MAX_EVENT_LOOPS = 64;
+const int MAX_CLIENTS_LIMIT = 1000000;
+const int MAX_LISTEN_BACKLOG = 65535;
+const int MAX_TIMEOUT_SECONDS = 86400;
+const int MAX_TARGETS = 10;				// targets of one PRIVMSG or NOTICE (TARGMAX)
 
 class Server
 {
@@ -35,65 +49,118 @@ public:
 	std::string 				getPassword() const;
 	void						setPort(int port);
 	void						setPassword(std::string passwd);
+	void						setConfig(const ServerConfig &config);
+	const ServerConfig			&getConfig() const;
 	void						runServer();
-	void						addClient(Client *client);
-	void						removeClient(int fd);
+	void						removeFromAllChannels(Client *client);
 
 	// runServer.cpp
-	void						handleEvents(std::vector<struct pollfd> &fds);
-	int							createServerSocket();
+	int							createServerSocket(bool reusePort);
 	void						bindAndListen(int server_fd);
-	void						handleNewClient(int server_fd);
-	void						cleanupResources(int server_fd);
-	void						sendTestMessage(int client_fd);
+	void						cleanupResources();
+	void						disconnectClient(Client &client, disconnectReason reason);
+	void						quitClient(Client &client, const std::string &reason);
+	void						clientClosed(Client &client);
+	void						reapClients();
+	EventLoop*					getMainLoop();
+	void						drainLoops();
+	void						notifyLoops();
+	bool						reserveConnection();
+	void						releaseConnection();
+	int							getConnectionCount() const;
+
+	// clientTimers.cpp
+	void						clientConnected(Client &client);
+	void						runTimers();
+	int							getTimerTimeout() const;
+	void						clientTimerExpired(Client &client);
+	void						timeoutClient(Client &client, const std::string &reason, disconnectReason metric);
+
+	// metricsReport.cpp
+	Metrics						&getMetrics();
+	void						recordLatencies();
+	void						writePrometheus(std::string &out) const;
+	void						writeStats(Client &client, char query);
+
+	// captureTraffic.cpp
+	void						startCapture();
+	void						stopCapture();
+	void						captureTraffic(captureRecordType type, Client &client, std::string_view line = {}, uint64_t timeUs = 0);
 
 	// messageHandler.cpp
-	void						handleClientMessage(Client &client, const std::string &message);
-	std::vector<std::string>	SplitString(const std::string &str);
-	void						MessageServerToClient(Client client, const std::string &message);
-	void						sendToChannelClients(Client *client, std::string message, std::string channelName);
+	void						handleLoopMessage(const LoopMessage &message);
+	void						handleClientMessage(Client &client, std::string_view line, uint64_t receivedAt = 0);
+	void						inputTooLong(Client &client);
+	void						MessageServerToClient(Client &client, Reply &reply);
+	void						sendToChannelClients(Channel *channel, Reply &reply, Client *except = nullptr);
+	void						sendToNeighbors(Client &client, Reply &reply);
+	void						queueLine(Client &client, const SharedLine &line);
 
 	// handleCommands.cpp
-	void						handleCAPs(Client &client, const std::vector<std::string>& tokens, int index);
-	void						handlePass(Client &client, const std::vector<std::string>& tokens, int index);
-	void						handleUserName(Client &client, std::vector<std::string> tokens, int index);
+	void						handlePing(Client &client, const IrcMessage &msg);
+	void						handlePong(Client &client, const IrcMessage &msg);
+	void						handleCAPs(Client &client, const IrcMessage &msg);
+	void						handlePass(Client &client, const IrcMessage &msg);
+	void						handleUserName(Client &client, const IrcMessage &msg);
 
-	void						handleJoin(Client &client, std::string channelName, std::string password);
-	void						handlePart(Client &client, std::vector<std::string> tokens, int index);
-	void						handlePrivmsg(Client &client, std::string channelNameOrNick, std::string &message);
+	void						handleJoin(Client &client, const IrcMessage &msg);
+	void						sendNames(Client &client, Channel *channel);
+	void						handlePart(Client &client, const IrcMessage &msg);
+	void						handlePrivmsg(Client &client, const IrcMessage &msg);
+	void						handleNotice(Client &client, const IrcMessage &msg);
+	void						deliverMessage(Client &client, const IrcMessage &msg, bool notice);
+	void						deliverToTarget(Client &client, std::string_view target, std::string_view text, bool notice, uint64_t epoch);
 	
-	void						handleNick(Client &client, std::string nick);
+	void						handleNick(Client &client, const IrcMessage &msg);
 	// channel handles these
-	void						handleKick(Client &client, std::string message);
-	void						handleTopic(Client &client, const std::string& channelName, std::string message);
-	void						handleInvite(Client &client, std::string message);
+	void						handleKick(Client &client, const IrcMessage &msg);
+	void						handleTopic(Client &client, const IrcMessage &msg);
+	void						handleInvite(Client &client, const IrcMessage &msg);
 	// parseChannelModes.cpp
-	void						handleQuit(Client &client, std::string message);
+	void						handleQuit(Client &client, const IrcMessage &msg);
+	void						handleOper(Client &client, const IrcMessage &msg);
+	void						handleStats(Client &client, const IrcMessage &msg);
 	
 	//handleModesParsing.cpp
 	bool						checkValidParameter(int index, std::vector<std::string> parameter, char mode, Channel *channel, Client& client);
-	bool						checkForValidModes(const std::string& message, Client& client, Channel* channel);
-	void						handleMode(Client& client, const std::string& channelName, const std::string& message);
+	bool						checkForValidModes(const IrcMessage &msg, Client& client, Channel* channel);
+	void						handleMode(Client& client, const IrcMessage &msg);
 	
 	//handleModesExecution.cpp
 	std::string					compressModes(const std::string& setModes);
 	void						executeModes(Client& client, Channel* channel);
 	
 	//channelClientGetters.cpp
-	std::vector<Channel *>&		getChannels();
-	std::vector<Client *>&		getClients();
-	bool						channelExists(const std::string& channelName);
-	Channel*					getChannelByChannelName(const std::string& channelName);
-	Client*						getClientByNickname(const std::string& nickname);
-	bool						userIsMemberOfChannel(Client &client, const std::string& channelName);
+	std::unordered_map<std::string, Channel *>&	getChannels();
+	bool						channelExists(std::string_view channelName);
+	Channel*					getChannelByChannelName(std::string_view channelName);
+	Channel*					createChannel(const std::string& channelName);
+	bool						removeClientFromChannel(Channel *channel, Client *client);
+	Client*						getClientByNickname(std::string_view nickname);
+	void						registerNick(Client &client, const std::string& nick);
+	void						unregisterNick(Client *client);
 
-	bool						checkIfChannelExists(const std::string& channelName);
-	bool						clientExists(const std::string& nick);
+	bool						clientExists(std::string_view nick);
 
 private:
+	void						markDisconnected(Client &client);
+
 
 	int							_port;
 	std::string					_passwd;
-	std::vector<Client *>		_clients;
-	std::vector<Channel *>		_channels;
+	ServerConfig				_config;
+	std::vector<EventLoop *>	_loops;
+	std::atomic<int>			_connections;		// open sockets over all loops
+	std::unordered_map<std::string, Channel *>	_channels;
+	std::unordered_map<std::string, Client *>	_nicknames;
+	std::vector<Client *>		_pendingRemoval;
+	std::vector<Client *>		_pendingRelease;
+	TimerWheel					_timers;
+	std::vector<Timer *>		_expiredTimers;
+	Metrics						_metrics;
+	std::vector<std::pair<int, uint64_t>>	_latencySamples;	// command index, receivedAt
+	AdminEndpoint				*_admin;
+	TrafficCapture				*_capture;			// nullptr unless --capture is given
+	uint64_t					_lastClientId;
+	uint64_t					_broadcastEpoch;		// see sendToNeighbors
 };
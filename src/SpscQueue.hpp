@@ -0,0 +1,95 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+const size_t	SPSC_BLOCK_SIZE = 256;
+
+/*Unbounded lock-free queue for exactly one producer thread and one consumer thread. Items are
+  stored in linked blocks of SPSC_BLOCK_SIZE slots, so a block is only allocated every
+  SPSC_BLOCK_SIZE pushes. The producer publishes the number of filled slots of its block with a
+  release store, the consumer frees a block once it has moved on to the next one. Being unbounded,
+  two event loops sending to each other can never block on a full queue.*/
+template <typename T>
+class SpscQueue
+{
+	public:
+		SpscQueue() : _head(new Block), _headPos(0), _tail(_head), _tailPos(0) {}
+		~SpscQueue()
+		{
+			while (_head)
+			{
+				Block *next = _head->next.load(std::memory_order_relaxed);
+				delete _head;
+				_head = next;
+			}
+		}
+
+		/*Producer side*/
+		void	push(T item)
+		{
+			if (_tailPos == SPSC_BLOCK_SIZE)
+			{
+				Block *block = new Block;
+				_tail->next.store(block, std::memory_order_release);
+				_tail = block;
+				_tailPos = 0;
+			}
+			_tail->slots[_tailPos] = std::move(item);
+			_tailPos++;
+			_tail->count.store(_tailPos, std::memory_order_release);
+		}
+
+		/*Consumer side, returns false if the queue is empty*/
+		bool	pop(T &item)
+		{
+			while (true)
+			{
+				if (_headPos < _head->count.load(std::memory_order_acquire))
+				{
+					item = std::move(_head->slots[_headPos]);
+					_headPos++;
+					return (true);
+				}
+				if (_headPos < SPSC_BLOCK_SIZE)
+					return (false);
+				Block *next = _head->next.load(std::memory_order_acquire);
+				if (next == nullptr)
+					return (false);
+				delete _head;
+				_head = next;
+				_headPos = 0;
+			}
+		}
+
+	private:
+		struct Block
+		{
+			T					slots[SPSC_BLOCK_SIZE];
+			std::atomic<size_t>	count{0};
+			std::atomic<Block *>	next{nullptr};
+		};
+
+		SpscQueue(const SpscQueue &other);
+		SpscQueue &operator=(const SpscQueue &other);
+
+		// consumer owned
+		alignas(64) Block	*_head;
+		size_t				_headPos;
+		// producer owned
+		alignas(64) Block	*_tail;
+		size_t				_tailPos;
+};
@@ -0,0 +1,169 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "TimerWheel.hpp"
+#include <ctime>
+
+const uint64_t	TIMER_SLOT_MASK = TIMER_SLOTS - 1;
+const uint64_t	TIMER_MAX_TICKS = (1ULL << (TIMER_SLOT_BITS * TIMER_LEVELS)) - 1;
+
+/* ************************************************Constructor Section START*************************************** */
+TimerWheel::TimerWheel() : _startMs(monotonicMs()), _tick(0), _nowMs(_startMs), _count(0)
+{
+	for (int level = 0; level < TIMER_LEVELS; level++)
+	{
+		for (int slot = 0; slot < TIMER_SLOTS; slot++)
+			_slots[level][slot].prev = _slots[level][slot].next = &_slots[level][slot];
+	}
+}
+
+TimerWheel::~TimerWheel() { clear(); }
+
+/* ************************************************Constructor Section END*************************************** */
+
+/*Unlinks all timers, has to be called before their owners are destroyed*/
+void	TimerWheel::clear()
+{
+	for (int level = 0; level < TIMER_LEVELS; level++)
+	{
+		for (int slot = 0; slot < TIMER_SLOTS; slot++)
+		{
+			Timer &head = _slots[level][slot];
+			while (head.next != &head)
+				cancel(*head.next);
+		}
+	}
+}
+
+/*Milliseconds of the monotonic clock, not affected by changes of the system time*/
+uint64_t	TimerWheel::monotonicMs()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000);
+}
+
+/*Time of the last advance()*/
+uint64_t	TimerWheel::getNowMs() const { return (_nowMs); }
+
+/*Amount of armed timers*/
+size_t		TimerWheel::size() const { return (_count); }
+
+uint64_t	TimerWheel::tickToMs(uint64_t tick) const { return (_startMs + tick * TIMER_TICK_MS); }
+
+/*Arms the timer to fire at expiresMs (rounded up to the next tick, at the earliest the next tick).
+  An armed timer is moved.*/
+void	TimerWheel::schedule(Timer &timer, uint64_t expiresMs)
+{
+	uint64_t tick = 0;
+
+	if (timer.isArmed())
+		cancel(timer);
+	if (expiresMs > _startMs)
+		tick = (expiresMs - _startMs + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+	timer.expires = (tick > _tick) ? tick : _tick + 1;
+	link(timer);
+	_count++;
+}
+
+void	TimerWheel::cancel(Timer &timer)
+{
+	if (!timer.isArmed())
+		return;
+	timer.prev->next = timer.next;
+	timer.next->prev = timer.prev;
+	timer.prev = timer.next = nullptr;
+	_count--;
+}
+
+/*Puts the timer into the lowest level whose range covers its distance from the current tick*/
+void	TimerWheel::link(Timer &timer)
+{
+	uint64_t	delta = timer.expires - _tick;
+	int			level = 0;
+
+	if (delta > TIMER_MAX_TICKS)
+	{
+		timer.expires = _tick + TIMER_MAX_TICKS;
+		delta = TIMER_MAX_TICKS;
+	}
+	while (level < TIMER_LEVELS - 1 && delta >= (1ULL << (TIMER_SLOT_BITS * (level + 1))))
+		level++;
+	Timer &head = _slots[level][(timer.expires >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK];
+	timer.prev = head.prev;
+	timer.next = &head;
+	head.prev->next = &timer;
+	head.prev = &timer;
+}
+
+/*Redistributes the timers of the current slot of the level into the levels below*/
+void	TimerWheel::cascade(int level)
+{
+	Timer &head = _slots[level][(_tick >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK];
+
+	while (head.next != &head)
+	{
+		Timer *timer = head.next;
+		head.next = timer->next;
+		timer->next->prev = &head;
+		link(*timer);
+	}
+}
+
+/*Moves the wheel forward to nowMs and appends the timers which expired to expired (unlinked, so
+  the caller may schedule them again). Without armed timers the wheel jumps to the current tick.*/
+void	TimerWheel::advance(uint64_t nowMs, std::vector<Timer *> &expired)
+{
+	uint64_t target = (nowMs > _startMs) ? (nowMs - _startMs) / TIMER_TICK_MS : 0;
+
+	_nowMs = nowMs;
+	if (_count == 0 && target > _tick)
+		_tick = target;
+	while (_tick < target)
+	{
+		_tick++;
+		for (int level = 1; level < TIMER_LEVELS; level++)
+		{
+			if (((_tick >> (TIMER_SLOT_BITS * (level - 1))) & TIMER_SLOT_MASK) != 0)
+				break;
+			cascade(level);
+		}
+		Timer &head = _slots[0][_tick & TIMER_SLOT_MASK];
+		while (head.next != &head)
+		{
+			Timer *timer = head.next;
+			cancel(*timer);
+			expired.push_back(timer);
+		}
+	}
+}
+
+/*Milliseconds until the next tick with work (an expiring timer or a cascade), the poller timeout
+  of the loop driving the wheel. -1 (wait forever) if no timer is armed.*/
+int	TimerWheel::getTimeoutMs(uint64_t nowMs) const
+{
+	if (_count == 0)
+		return (-1);
+	uint64_t next = ((_tick >> TIMER_SLOT_BITS) + 1) << TIMER_SLOT_BITS;
+	for (uint64_t tick = _tick + 1; tick < next; tick++)
+	{
+		const Timer &head = _slots[0][tick & TIMER_SLOT_MASK];
+		if (head.next != &head)
+		{
+			next = tick;
+			break;
+		}
+	}
+	uint64_t wakeMs = tickToMs(next);
+	return (wakeMs > nowMs ? static_cast<int>(wakeMs - nowMs) : 0);
+}
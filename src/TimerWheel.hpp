@@ -0,0 +1,73 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const uint64_t	TIMER_TICK_MS = 250;
+const int		TIMER_LEVELS = 4;
+const int		TIMER_SLOT_BITS = 6;
+const int		TIMER_SLOTS = 1 << TIMER_SLOT_BITS;
+
+/*Intrusive timer, embedded in the object it belongs to (owner). A timer is armed while it is
+  linked into a slot of the wheel.*/
+struct Timer
+{
+	Timer		*prev = nullptr;
+	Timer		*next = nullptr;
+	uint64_t	expires = 0;		// in ticks
+	void		*owner = nullptr;
+
+	bool	isArmed() const { return (next != nullptr); }
+};
+
+/*Hierarchical timer wheel with TIMER_LEVELS levels of TIMER_SLOTS slots. Level 0 has one slot per
+  tick, every further level covers TIMER_SLOTS times the range of the level below. A timer is put
+  into the level matching its distance from the current tick, when the lower level wraps around the
+  timers of the next slot of the level above are redistributed (cascaded) into it. Scheduling and
+  cancelling are O(1), every timer is cascaded at most TIMER_LEVELS - 1 times. Timers further away
+  than the wheel covers (about 48 days) fire at its end.
+
+  Time is passed in milliseconds of CLOCK_MONOTONIC (see monotonicMs) and rounded up to whole
+  ticks, so timers never fire early.*/
+class TimerWheel
+{
+	public:
+		TimerWheel();
+		TimerWheel(const TimerWheel &other) = delete;
+		TimerWheel &operator=(const TimerWheel &other) = delete;
+		~TimerWheel();
+
+		void		schedule(Timer &timer, uint64_t expiresMs);
+		void		cancel(Timer &timer);
+		void		advance(uint64_t nowMs, std::vector<Timer *> &expired);
+		void		clear();
+		int			getTimeoutMs(uint64_t nowMs) const;
+		uint64_t	getNowMs() const;
+		size_t		size() const;
+
+		static uint64_t	monotonicMs();
+
+	private:
+		void		link(Timer &timer);
+		void		cascade(int level);
+		uint64_t	tickToMs(uint64_t tick) const;
+
+		Timer		_slots[TIMER_LEVELS][TIMER_SLOTS];		// list heads
+		uint64_t	_startMs;
+		uint64_t	_tick;
+		uint64_t	_nowMs;
+		size_t		_count;
+};
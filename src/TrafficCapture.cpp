@@ -0,0 +1,192 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "TrafficCapture.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+static const char	CAPTURE_MAGIC[] = "IRCCAP1\n";
+static const size_t	CAPTURE_MAGIC_SIZE = sizeof(CAPTURE_MAGIC) - 1;
+
+/*Length of the part of the line to keep if it is a PASS or OPER, 0 otherwise (the command may
+  follow a prefix and is case insensitive)*/
+static size_t	secretCommandEnd(std::string_view line)
+{
+	size_t start = 0;
+
+	if (!line.empty() && line[0] == ':')
+	{
+		start = line.find(' ');
+		if (start == std::string_view::npos)
+			return (0);
+		start = line.find_first_not_of(' ', start);
+		if (start == std::string_view::npos)
+			return (0);
+	}
+	size_t end = std::min(line.find(' ', start), line.size());
+	std::string_view command = line.substr(start, end - start);
+	if (command.size() != 4)
+		return (0);
+	std::string upper(command);
+	for (char &c : upper)
+		c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+	return ((upper == "PASS" || upper == "OPER") ? end : 0);
+}
+
+/* ************************************************Constructor Section START*************************************** */
+/*Creates (or truncates) the capture file, readable by the owner only as it holds the traffic of
+  the users. Throws std::system_error if it can not be created.*/
+TrafficCapture::TrafficCapture(const std::string &path) : _lastTime(0), _records(0)
+{
+	_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (_fd == -1)
+		throw std::system_error(errno, std::generic_category(), "Could not create capture file " + path);
+	_buffer.reserve(CAPTURE_BUFFER_SIZE * 2);
+	_buffer.append(CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE);
+}
+
+TrafficCapture::~TrafficCapture()
+{
+	flush();
+	close(_fd);
+}
+
+/* ************************************************Constructor Section END*************************************** */
+
+/*Appends a record, the buffer is written once it holds CAPTURE_BUFFER_SIZE bytes. timeUs is a
+  monotonic time in microseconds, records are expected in time order. Returns false if writing
+  failed.*/
+bool	TrafficCapture::record(captureRecordType type, uint64_t connection, uint64_t timeUs, std::string_view line)
+{
+	uint64_t delta = (_records == 0 || timeUs < _lastTime) ? 0 : timeUs - _lastTime;
+
+	if (_records == 0 || timeUs > _lastTime)
+		_lastTime = timeUs;
+	_buffer.push_back(static_cast<char>(type));
+	putVarint(connection);
+	putVarint(delta);
+	if (type == CAPTURE_LINE)
+	{
+		size_t keep = secretCommandEnd(line);
+		if (keep != 0 && keep < line.size())
+		{
+			putVarint(keep + 2);
+			_buffer.append(line.substr(0, keep));
+			_buffer.append(" *");
+		}
+		else
+		{
+			putVarint(line.size());
+			_buffer.append(line);
+		}
+	}
+	_records++;
+	if (_buffer.size() >= CAPTURE_BUFFER_SIZE)
+		return (flush());
+	return (true);
+}
+
+/*Writes the buffered records to the file*/
+bool	TrafficCapture::flush()
+{
+	size_t written = 0;
+
+	while (written < _buffer.size())
+	{
+		ssize_t bytes = write(_fd, _buffer.data() + written, _buffer.size() - written);
+		if (bytes == -1 && errno == EINTR)
+			continue;
+		if (bytes <= 0)
+			return (false);
+		written += bytes;
+	}
+	_buffer.clear();
+	return (true);
+}
+
+uint64_t	TrafficCapture::getRecords() const { return (_records); }
+
+void	TrafficCapture::putVarint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		_buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	_buffer.push_back(static_cast<char>(value));
+}
+
+/* ************************************************Constructor Section START*************************************** */
+/*Loads the whole capture. Throws std::runtime_error if the file can not be read or is no capture.*/
+CaptureReader::CaptureReader(const std::string &path) : _offset(CAPTURE_MAGIC_SIZE), _time(0)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file)
+		throw std::runtime_error("Could not open capture file " + path);
+	_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if (_data.compare(0, CAPTURE_MAGIC_SIZE, CAPTURE_MAGIC) != 0)
+		throw std::runtime_error(path + " is not a capture file");
+}
+
+CaptureReader::~CaptureReader() {}
+
+/* ************************************************Constructor Section END*************************************** */
+
+/*Reads the next record. Returns false at the end of the file, throws std::runtime_error if the
+  file ends within a record or holds an unknown record type.*/
+bool	CaptureReader::next(CaptureRecord &record)
+{
+	if (_offset >= _data.size())
+		return (false);
+	int type = static_cast<unsigned char>(_data[_offset++]);
+	if (type < CAPTURE_CONNECT || type > CAPTURE_DISCONNECT)
+		throw std::runtime_error("Corrupt capture file: unknown record type");
+	record.type = static_cast<captureRecordType>(type);
+	record.connection = getVarint();
+	_time += getVarint();
+	record.time = _time;
+	record.line.clear();
+	if (record.type == CAPTURE_LINE)
+	{
+		uint64_t length = getVarint();
+		if (length > _data.size() - _offset)
+			throw std::runtime_error("Truncated capture file");
+		record.line.assign(_data, _offset, length);
+		_offset += length;
+	}
+	return (true);
+}
+
+uint64_t	CaptureReader::getVarint()
+{
+	uint64_t	value = 0;
+	int			shift = 0;
+
+	while (true)
+	{
+		if (_offset >= _data.size() || shift > 63)
+			throw std::runtime_error("Truncated capture file");
+		unsigned char byte = static_cast<unsigned char>(_data[_offset++]);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return (value);
+		shift += 7;
+	}
+}
@@ -0,0 +1,86 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+const size_t	CAPTURE_BUFFER_SIZE = 64 * 1024;
+
+enum captureRecordType
+{
+	CAPTURE_CONNECT = 1,
+	CAPTURE_LINE,
+	CAPTURE_DISCONNECT
+};
+
+struct CaptureRecord
+{
+	captureRecordType	type = CAPTURE_LINE;
+	uint64_t			connection = 0;		// session id (Client::getId)
+	uint64_t			time = 0;			// microseconds since the first record
+	std::string			line;				// LINE: without CRLF
+};
+
+/*
+	Capture of the inbound traffic: connects, received lines and disconnects with their time and
+	session, the input of a replay (bench/ircreplay.cpp). File format:
+
+		"IRCCAP1\n", then per record:
+		type (1 byte) | connection (varint) | microseconds since the previous record (varint)
+		LINE records continue with: length (varint) | the line without CRLF
+
+	Varints are unsigned LEB128 (7 bits per byte, low bits first), so a typical PRIVMSG costs 4 to
+	6 bytes on top of its text. The parameters of PASS and OPER are replaced by "*".
+*/
+class TrafficCapture
+{
+	public:
+		TrafficCapture(const std::string &path);
+		TrafficCapture(const TrafficCapture &other) = delete;
+		TrafficCapture &operator=(const TrafficCapture &other) = delete;
+		~TrafficCapture();
+
+		bool		record(captureRecordType type, uint64_t connection, uint64_t timeUs, std::string_view line = {});
+		bool		flush();
+		uint64_t	getRecords() const;
+
+	private:
+		void		putVarint(uint64_t value);
+
+		int			_fd;
+		std::string	_buffer;
+		uint64_t	_lastTime;
+		uint64_t	_records;
+};
+
+/*Reads the records of a capture file one after the other*/
+class CaptureReader
+{
+	public:
+		CaptureReader(const std::string &path);
+		CaptureReader(const CaptureReader &other) = delete;
+		CaptureReader &operator=(const CaptureReader &other) = delete;
+		~CaptureReader();
+
+		bool		next(CaptureRecord &record);
+
+	private:
+		uint64_t	getVarint();
+
+		std::string	_data;
+		size_t		_offset;
+		uint64_t	_time;
+};
@@ -0,0 +1,52 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#pragma once
+
+#include "SendQueue.hpp"
+#include <cstdint>
+
+class Client;
+
+/*Messages exchanged between the transport owning a connection and the main loop (loop 0). CONNECT,
+  LINE, LINE_TOO_LONG and DISCONNECT travel from the owner of the connection to the main loop, SEND,
+  CLOSE and RELEASE from the main loop to the owner.*/
+enum loopMessageType
+{
+	LOOP_CONNECT,
+	LOOP_LINE,
+	LOOP_LINE_TOO_LONG,
+	LOOP_DISCONNECT,
+	LOOP_SEND,
+	LOOP_CLOSE,
+	LOOP_RELEASE
+};
+
+struct LoopMessage
+{
+	loopMessageType	type = LOOP_LINE;
+	Client			*client = nullptr;
+	SharedLine		line;
+	uint64_t		receivedAt = 0;		// LINE: monotonic microseconds of the read
+};
+
+/*The side of a client which is not IRC state: what the main loop posts SEND, CLOSE and RELEASE to.
+  Connections accepted from a socket are owned by an EventLoop, simulated ones by a
+  LoopbackTransport. The server only ever talks to the transport of a client through
+  postFromMain(), so both drive the same command handlers.*/
+class Transport
+{
+	public:
+		virtual ~Transport() = default;
+
+		virtual void	postFromMain(const LoopMessage &message) = 0;
+};
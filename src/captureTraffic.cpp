@@ -0,0 +1,57 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Server.hpp"
+#include <cerrno>
+#include <cstring>
+
+/*
+	Capture of the inbound traffic (--capture=FILE, see TrafficCapture.hpp). Everything is recorded
+	on the main loop: connects when the session starts, every line before it is parsed and
+	disconnects once the connection is closed, with the session id of the client. Replay a capture
+	with bench/ircreplay.cpp.
+*/
+
+/*Opens the capture file if one is configured, throws std::system_error if it can not be created*/
+void Server::startCapture()
+{
+	if (_config.capturePath.empty())
+		return;
+	_capture = new TrafficCapture(_config.capturePath);
+	LOG(LEVEL_INFO, LOG_CORE, "Capturing the inbound traffic to " << _config.capturePath);
+}
+
+/*Writes what is left of the capture and closes it*/
+void Server::stopCapture()
+{
+	if (_capture == nullptr)
+		return;
+	if (!_capture->flush())
+		LOG(LEVEL_ERROR, LOG_CORE, "Writing the capture failed: " << std::strerror(errno));
+	else
+		LOG(LEVEL_INFO, LOG_CORE, _capture->getRecords() << " records captured to " << _config.capturePath);
+	delete _capture;
+	_capture = nullptr;
+}
+
+/*Records one event of the client. timeUs is the monotonic time of the read in microseconds, 0 for
+  now. The capture is stopped if it can not be written.*/
+void Server::captureTraffic(captureRecordType type, Client &client, std::string_view line, uint64_t timeUs)
+{
+	if (timeUs == 0)
+		timeUs = Metrics::monotonicMicros();
+	if (_capture->record(type, client.getId(), timeUs, line))
+		return;
+	LOG(LEVEL_ERROR, LOG_CORE, "Writing the capture failed, capture stopped: " << std::strerror(errno));
+	delete _capture;
+	_capture = nullptr;
+}
@@ -0,0 +1,28 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "CaseMapping.hpp"
+
+/*Folds a nick or channel name with the rfc1459 case mapping (RFC 1459 2.2): characters 65-94
+  (A-Z and [\]^) are the upper case forms of 97-126 (a-z and {|}~). Two names are equal for the
+  protocol if their folded forms are equal, so the result is used as key of the name indexes.*/
+std::string	ircToLower(std::string_view name)
+{
+	std::string	folded(name);
+
+	for (char &c : folded)
+	{
+		if (c >= 'A' && c <= '^')
+			c += 'a' - 'A';
+	}
+	return (folded);
+}
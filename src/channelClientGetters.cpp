@@ -13,79 +13,79 @@
 #include "Channel.hpp"
 #include "Client.hpp"
 #include "Server.hpp"
-#include <algorithm>
+#include "CaseMapping.hpp"
 
 
 /*THESE FUNCTIONS ARE USED IN THE CONTEXT OF CHANNEL MODES HANDLING*/
 
-/*Returns all channel objects from the server*/
-std::vector<Channel *>& Server::getChannels() {
+/*Returns all channel objects from the server, keyed by case-folded channel name*/
+std::unordered_map<std::string, Channel *>& Server::getChannels() {
 	return (_channels);
 }
 
-/*Returns all client objects from the server*/
-std::vector<Client *>& Server::getClients() {
-	return (_clients);
+/*Checks if passed channel name exists in the channel index. Returns true in case channel exists.*/
+bool	Server::channelExists(std::string_view channelName)
+{
+	return (getChannelByChannelName(channelName) != nullptr);
 }
 
-/*Checks if passed channel name exists in vector of channels. Returns true in case channel exists.*/
-bool	Server::channelExists(const std::string& channelName)
+/*Returns Channel object by passing it's name to the function. Channel names are case insensitive,
+  the folded name is looked up in the channel index. If object cannot be found by channel name,
+  returns nullptr.*/
+Channel*	Server::getChannelByChannelName(std::string_view channelName)
 {
-	auto it = find_if(getChannels().begin(), getChannels().end(), [&channelName](Channel *channel)
-	{ return channel->getChannelName() == channelName; });
-	if (it != getChannels().end())
-		return (true);
-	else
-		return (false);
+	auto it = _channels.find(ircToLower(channelName));
+	if (it != _channels.end())
+		return (it->second);
+	return (nullptr);
 }
 
-/*Returns Channel object by passing it's name to the function. If object cannot be found by channel
-  name, returns nullptr.*/
-Channel*	Server::getChannelByChannelName(const std::string& channelName)
+/*Creates a new channel and adds it to the channel index*/
+Channel*	Server::createChannel(const std::string& channelName)
 {
-	const auto& channels = getChannels();
-	auto it = std::find_if(channels.begin(), channels.end(), [&channelName](Channel* channel)
-	{ return channel->getChannelName() == channelName; });
-	if (it != channels.end())
-		return (*it);
-	return (nullptr);
+	Channel *channel = new Channel(channelName);
+	channel->setTimestamp();
+	_channels[ircToLower(channelName)] = channel;
+	return (channel);
 }
 
-/*Returns Client object by passing it's name to the function. If object cannot be found by client
-  name, returns nullptr.*/
-Client*	Server::getClientByNickname(const std::string& nickname)
+/*Removes the client from the channel's member and operator lists. A channel without members is
+  removed from the channel index and destroyed, so the channel pointer must not be used afterwards
+  if this function returns true.*/
+bool	Server::removeClientFromChannel(Channel *channel, Client *client)
 {
-	const auto& client = getClients();
-	auto it = std::find_if(client.begin(), client.end(), [&nickname](Client* client)
-	{ return client->getNick() == nickname; });
-	if (it != client.end())
-		return (*it);
-	return (nullptr);
+	channel->removeClient(client);
+	channel->unsetChOperator(client);
+	if (!channel->getUsers().empty())
+		return (false);
+	_channels.erase(ircToLower(channel->getChannelName()));
+	delete channel;
+	return (true);
 }
 
-/*Returns client object by passing a client nickname to the method.*/
-Client*	Channel::getClientByNickname(const std::string& nickname)
+/*Returns Client object by passing it's name to the function. The nick is looked up case insensitively
+  in the nick index (see registerNick). If object cannot be found by client name, returns nullptr.*/
+Client*	Server::getClientByNickname(std::string_view nickname)
 {
-	const auto& client = getUsers();
-	auto it = std::find_if(client.begin(), client.end(), [&nickname](Client* client)
-	{ return client->getNick() == nickname; });
-	if (it != client.end())
-		return (*it);
+	auto it = _nicknames.find(ircToLower(nickname));
+	if (it != _nicknames.end())
+		return (it->second);
 	return (nullptr);
 }
 
-/*Checks if user is member of channel by retrieving channel with help of passed channel name and then
-  check within the user list of the channel of occurence for passed user(client).*/
-bool	Server::userIsMemberOfChannel(Client &client, const std::string& channelName)
+/*Sets a new nick for the client and keeps the nick index in sync. The caller has to make sure that
+  the nick is not used by another client.*/
+void	Server::registerNick(Client &client, const std::string& nick)
+{
+	unregisterNick(&client);
+	client.setNick(nick);
+	_nicknames[ircToLower(nick)] = &client;
+}
+
+/*Removes the client's current nick from the nick index*/
+void	Server::unregisterNick(Client *client)
 {
-	auto it = std::find_if(getChannels().begin(), getChannels().end(), [&channelName](Channel* channel)
-	{ return channel->getChannelName() == channelName; });
-	if (it != getChannels().end()) {
-		Channel* channel = *it;
-		auto& users = channel->getUsers();
-		auto userIt = std::find(users.begin(), users.end(), &client);
-		if (userIt != users.end())
-			return (true);
-	}
-	return (false);
+	auto it = _nicknames.find(ircToLower(client->getNick()));
+	if (it != _nicknames.end() && it->second == client)
+		_nicknames.erase(it);
 }
@@ -0,0 +1,96 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Server.hpp"
+#include "response.hpp"
+
+/*
+	Every session has one keepalive timer in the timer wheel of the main loop. It is not moved when
+	input arrives, received lines only store the time (see handleClientMessage). When the timer
+	fires, clientTimerExpired looks at the state of the session and either acts or arms the timer
+	again for the time which is left:
+	 - REGISTERING: the registration has to be completed registrationTimeout seconds after connecting
+	 - REGISTERED: after pingInterval seconds without input a PING is sent, if nothing arrives
+	   within pingTimeout seconds after it the client is dropped
+*/
+
+/*A new connection, the registration deadline starts*/
+void Server::clientConnected(Client &client)
+{
+	uint64_t now = _timers.getNowMs();
+
+	client.setId(++_lastClientId);
+	if (_capture != nullptr)
+		captureTraffic(CAPTURE_CONNECT, client);
+	client.setConnectedAt(now);
+	client.setLastActivity(now);
+	client.setPingSent(0);
+	client.getTimer().owner = &client;
+	_timers.schedule(client.getTimer(), now + _config.registrationTimeout * 1000ULL);
+}
+
+/*Moves the timer wheel to the current time and handles the expired timers. Called once per main
+  loop iteration before the events.*/
+void Server::runTimers()
+{
+	_expiredTimers.clear();
+	_timers.advance(TimerWheel::monotonicMs(), _expiredTimers);
+	for (Timer *timer : _expiredTimers)
+		clientTimerExpired(*static_cast<Client *>(timer->owner));
+}
+
+/*Poller timeout of the main loop, -1 if no timer is armed*/
+int Server::getTimerTimeout() const
+{
+	return (_timers.getTimeoutMs(TimerWheel::monotonicMs()));
+}
+
+void Server::clientTimerExpired(Client &client)
+{
+	uint64_t now = _timers.getNowMs();
+	uint64_t deadline;
+
+	if (client.getState() == DISCONNECTED)
+		return;
+	if (client.getState() == REGISTERING)
+	{
+		deadline = client.getConnectedAt() + _config.registrationTimeout * 1000ULL;
+		if (now >= deadline)
+			return (timeoutClient(client, "Registration timeout", DISCONNECT_REGISTRATION_TIMEOUT));
+	}
+	else if (client.getPingSent() != 0)
+	{
+		deadline = client.getPingSent() + _config.pingTimeout * 1000ULL;
+		if (now >= deadline)
+			return (timeoutClient(client, "Ping timeout", DISCONNECT_PING_TIMEOUT));
+	}
+	else
+	{
+		deadline = client.getLastActivity() + _config.pingInterval * 1000ULL;
+		if (now >= deadline)
+		{
+			MessageServerToClient(client, RPL_PING(std::string("ft_irc")));
+			client.setPingSent(now);
+			deadline = now + _config.pingTimeout * 1000ULL;
+		}
+	}
+	_timers.schedule(client.getTimer(), deadline);
+}
+
+/*Tells the client and its neighbors why the link is closed and disconnects it*/
+void Server::timeoutClient(Client &client, const std::string &reason, disconnectReason metric)
+{
+	LOG(LEVEL_INFO, LOG_CLIENT, client.getNick() << " timed out: " << reason);
+	MessageServerToClient(client, ERR_CLOSINGLINK(client.getNick(), reason));
+	quitClient(client, reason);
+	disconnectClient(client, metric);
+}
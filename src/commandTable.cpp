@@ -0,0 +1,104 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "CommandTable.hpp"
+#include "Server.hpp"
+#include <cctype>
+
+const unsigned	COMMAND_SLOTS = 128;
+const unsigned	COMMAND_HASH_SEED = 33;
+
+/*All commands known to the server with their handler, the minimum amount of parameters and the
+  registration states in which they are accepted. Checked by handleClientMessage before calling
+  the handler.*/
+static constexpr CommandEntry	commandTable[] = {
+	{"CAP",		&Server::handleCAPs,		1,	ALLOW_ALWAYS},
+	{"PASS",	&Server::handlePass,		1,	ALLOW_REGISTERING},
+	{"NICK",	&Server::handleNick,		0,	ALLOW_ALWAYS},
+	{"USER",	&Server::handleUserName,	4,	ALLOW_REGISTERING},
+	{"PING",	&Server::handlePing,		1,	ALLOW_ALWAYS},
+	{"PONG",	&Server::handlePong,		0,	ALLOW_ALWAYS},
+	{"QUIT",	&Server::handleQuit,		0,	ALLOW_ALWAYS},
+	{"JOIN",	&Server::handleJoin,		1,	ALLOW_REGISTERED},
+	{"PRIVMSG",	&Server::handlePrivmsg,		2,	ALLOW_REGISTERED},
+	{"NOTICE",	&Server::handleNotice,		2,	ALLOW_REGISTERED},
+	{"MODE",	&Server::handleMode,		1,	ALLOW_REGISTERED},
+	{"TOPIC",	&Server::handleTopic,		1,	ALLOW_REGISTERED},
+	{"KICK",	&Server::handleKick,		2,	ALLOW_REGISTERED},
+	{"INVITE",	&Server::handleInvite,		2,	ALLOW_REGISTERED},
+	{"OPER",	&Server::handleOper,		2,	ALLOW_REGISTERED},
+	{"STATS",	&Server::handleStats,		0,	ALLOW_REGISTERED},
+};
+
+const int	COMMAND_COUNT = sizeof(commandTable) / sizeof(commandTable[0]);
+static_assert(COMMAND_COUNT <= MAX_COMMANDS, "raise MAX_COMMANDS");
+
+/*Case insensitive hash of a command name, letters are folded to upper case with & 0xDF*/
+static constexpr unsigned	commandHash(std::string_view name)
+{
+	unsigned hash = name.size();
+	for (char c : name)
+		hash = hash * COMMAND_HASH_SEED + (static_cast<unsigned char>(c) & 0xDF);
+	return (hash % COMMAND_SLOTS);
+}
+
+struct CommandSlots
+{
+	signed char	index[COMMAND_SLOTS];
+	bool		collision;
+};
+
+/*Maps every hash slot to the position of its command in commandTable (or -1). Built at compile
+  time, the static_assert below guarantees that the hash is collision free (perfect) for the
+  commands in the table, so a lookup is one hash and one string compare.*/
+static constexpr CommandSlots	buildCommandSlots()
+{
+	CommandSlots slots = {};
+	for (unsigned i = 0; i < COMMAND_SLOTS; i++)
+		slots.index[i] = -1;
+	for (int i = 0; i < COMMAND_COUNT; i++)
+	{
+		unsigned slot = commandHash(commandTable[i].name);
+		if (slots.index[slot] != -1)
+			slots.collision = true;
+		slots.index[slot] = i;
+	}
+	return (slots);
+}
+
+static constexpr CommandSlots	commandSlots = buildCommandSlots();
+static_assert(!commandSlots.collision, "command names collide in commandHash, change COMMAND_HASH_SEED");
+
+/*Returns the table entry of the command (case insensitive) or nullptr for unknown commands*/
+const CommandEntry	*findCommand(std::string_view name)
+{
+	int index = commandSlots.index[commandHash(name)];
+	if (index == -1)
+		return (nullptr);
+	const char *known = commandTable[index].name;
+	size_t i = 0;
+	for (; i < name.size() && known[i] != '\0'; i++)
+	{
+		if (std::toupper(static_cast<unsigned char>(name[i])) != known[i])
+			return (nullptr);
+	}
+	if (i != name.size() || known[i] != '\0')
+		return (nullptr);
+	return (&commandTable[index]);
+}
+
+int	getCommandCount() { return (COMMAND_COUNT); }
+
+const CommandEntry	&getCommandEntry(int index) { return (commandTable[index]); }
+
+/*Position of the entry in the table, e.g. to index per command counters*/
+int	getCommandIndex(const CommandEntry *entry) { return (static_cast<int>(entry - commandTable)); }
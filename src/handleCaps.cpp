@@ -15,44 +15,39 @@
 
 /*Checks whether CAPS and related string parameters are received correctly and if on receiving 'END' required
   fields NICK, USER and PASSWORD are filled by client*/
-void Server::handleCAPs(Client &client, const std::vector<std::string>& tokens, int index)
+void Server::handleCAPs(Client &client, const IrcMessage &msg)
 {
-	std::string response;
-	if (tokens[index + 1] == "LS") {
-		response = "CAP * LS :multi-prefix sasl";
-		MessageServerToClient(client, response);
-	}
-	else if (tokens[index + 1] == "REQ") {
-		response = ":localhost CAP " + client.getNick() + " ACK :multi-prefix";
-		MessageServerToClient(client, response);
-	}
-	else if (tokens[index + 1] == "END") {
-		std::cout << "END sended" << std::endl;
+	std::string_view subcommand = msg.param(0);
+	if (subcommand == "LS")
+		MessageServerToClient(client, RPL_CAP("*", "LS", "multi-prefix sasl"));
+	else if (subcommand == "REQ")
+		MessageServerToClient(client, RPL_CAP(client.getNick(), "ACK", "multi-prefix"));
+	else if (subcommand == "END" && client.getState() == REGISTERING) {
+		LOG(LEVEL_DEBUG, LOG_CLIENT, "END sended");
 		if (!client.getPasswdOK()) {
 			MessageServerToClient(client, RPL_PASSWDREQUEST());
 			MessageServerToClient(client, ERR_PASSWDMISMATCH(client.getNick()));
-			close(client.getFd());
-			removeClient(client.getFd());
+			disconnectClient(client, DISCONNECT_REGISTRATION_FAILED);
 			return;
 		}
 		else if (!client.getNickOK()) {
 			MessageServerToClient(client, RPL_NICKREQUEST());
 			MessageServerToClient(client, ERR_NONICKNAMEGIVEN());
-			close(client.getFd());
-			removeClient(client.getFd());
+			disconnectClient(client, DISCONNECT_REGISTRATION_FAILED);
 			return;
 		}
 		else if (!client.getUserNameOK()) {
 			MessageServerToClient(client, RPL_USERNAMEREQUEST());
-			close(client.getFd());
-			removeClient(client.getFd());
+			disconnectClient(client, DISCONNECT_REGISTRATION_FAILED);
 			return;
 		}
 		else {
 			client.setState(REGISTERED);
 			MessageServerToClient(client, RPL_WELCOME(client.getNick()));
+			MessageServerToClient(client, RPL_ISUPPORT(client.getNick(), "CASEMAPPING=rfc1459 CHANTYPES=# NICKLEN="
+				+ std::to_string(MAX_NICK_LENGTH) + " TARGMAX=PRIVMSG:" + std::to_string(MAX_TARGETS) + ",NOTICE:" + std::to_string(MAX_TARGETS)));
 		}	
 	}
 	else
-		std::cerr << "Invalid CAP message" << std::endl;
+		LOG(LEVEL_DEBUG, LOG_CLIENT, "Invalid CAP message");
 }
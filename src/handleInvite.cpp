@@ -13,23 +13,18 @@
 #include "Server.hpp"
 #include "Channel.hpp"
 #include "response.hpp"
-#include <sstream>
 
 /*Handles invite of a user to a channel. First checks whether channel and client exists, then
   sends invite in case respective parameters such as inviter is operator, in the channel and
   invitee is not yet in the channel. Finally adds invitee to invitation list. */
-void Server::handleInvite(Client &client, std::string message)
+void Server::handleInvite(Client &client, const IrcMessage &msg)
 {
-	std::cout << "try to invite" << std::endl;
-	std::istringstream	iss(message);
-	std::string			command;
-	std::string			nick;
-	std::string			channelName;
-	iss >> command;
-	iss >> nick;
-	iss >> channelName;
+	LOG(LEVEL_DEBUG, LOG_CLIENT, "try to invite");
+	std::string			nick(msg.param(0));
+	std::string			channelName(msg.param(1));
 	
-	if (!checkIfChannelExists(channelName)) {
+	Channel *channel = getChannelByChannelName(channelName);
+	if (!channel) {
 		MessageServerToClient(client, ERR_NOSUCHCHANNEL(client.getNick(), channelName));
 		return;
 	}
@@ -39,17 +34,20 @@ void Server::handleInvite(Client &client, std::string message)
 		return;
 	}
 	try {
-		getChannelByChannelName(channelName)->setInvite(&client, channelName, nick);
+		channel->setInvite(&client, clientToInvite);
 	}
 	catch (const Channel::ClientNotOperatorException &e) {
 		MessageServerToClient(client, ERR_CHANOPRIVSNEEDED(client.getNick(), channelName));
+		return;
 	}
 	catch (const Channel::ClientNotInChannelException &e) {
-		MessageServerToClient(client, ERR_USERNOTINCHANNEL(client.getNick(), nick, channelName));
+		MessageServerToClient(client, ERR_NOTONCHANNEL(client.getNick(), channelName));
+		return;
 	}
 	catch (const Channel::ClientAlreadyInChannelException &e) {
 		MessageServerToClient(client, ERR_USERONCHANNEL(client.getNick(), nick, channelName));
+		return;
 	}
 	MessageServerToClient(*clientToInvite, RPL_INVITING(client.getNick(), nick, channelName));
-	getChannelByChannelName(channelName)->addToInvitationList(clientToInvite);
+	channel->addToInvitationList(clientToInvite);
 }
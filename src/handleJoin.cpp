@@ -15,15 +15,27 @@
 #include "response.hpp"
 #include <sstream>
 
+/*Sends the names list of the channel (RPL_NAMREPLY, one reply per chunk) and its end to the client*/
+void	Server::sendNames(Client &client, Channel *channel)
+{
+	for (const std::string &chunk : channel->getNamesChunks())
+		MessageServerToClient(client, RPL_NAMREPLY(client.getNick(), channel->getChannelName(), chunk));
+	MessageServerToClient(client, RPL_ENDOFNAMES(client.getNick(), channel->getChannelName()));
+}
+
 /*Adds user(client) to a channel or creates new channel in case channel is not yet existing.
-  First checks if channel name already exists in vector array of _channels. If this is the case,
-  adds client to the channel (if no channel restrictions apply) and sends message about new member
-  to all members in channel. Otherwise creates pointer to a new channel via 'new' (to ensure that
-  class will exist further on and not go out of scope when function terminates).*/
-void	Server::handleJoin(Client &client, std::string channels, std::string password)
+  Each name of the comma separated list is looked up once in the channel index. If the channel
+  exists, adds client to the channel (if no channel restrictions apply), sends message about new
+  member to all members in channel and the names list (rendered once per channel version, see
+  Channel::getNamesChunks) to the new member. Otherwise creates a new channel with the client as operator.
+  A failing channel does not stop the remaining channels of the list from being joined.*/
+void	Server::handleJoin(Client &client, const IrcMessage &msg)
 {
+	std::string channels(msg.param(0));
+	std::string password(msg.param(1));
+
 	if (channels == "")
-		MessageServerToClient(client, "\r\n");
+		MessageServerToClient(client, ERR_NEEDMOREPARAMS(client.getNick(), "JOIN"));
 	else
 	{
 		std::stringstream ss(channels);
@@ -31,39 +43,29 @@ void	Server::handleJoin(Client &client, std::string channels, std::string passwo
 
 		while (std::getline(ss, channelName, ',')) 
 		{
-			std::string namesList = "";
-			bool channelExists = false;
-			for (Channel *availableChannels : _channels) {
-				if (channelName == availableChannels->getChannelName()) {
-					std::string namesList = "";
-					if (!availableChannels->checkForModeRestrictions(client, password,
-						[&](Client &client, const std::string &response) { MessageServerToClient(client, response); }))
-						return ;
-					availableChannels->addClient(&client);
-					for (Client *clientsIn : availableChannels->getUsers())
-						namesList.append(clientsIn->getNick() + " ");
-					for (Client *member : getChannelByChannelName(channelName)->getUsers()) {
-						MessageServerToClient(*member, RPL_JOIN(client.getNick(), channelName));
-						MessageServerToClient(*member, RPL_NAMREPLY(client.getNick(), channelName, namesList));
-						MessageServerToClient(*member, RPL_ENDOFNAMES(client.getNick(), channelName));
-					}
-					channelExists = true;
-					return;
-				} 
+			if (channelName.empty() || channelName[0] != '#') {
+				MessageServerToClient(client, ERR_NOSUCHCHANNEL(client.getNick(), channelName));
+				continue ;
+			}
+			Channel *channel = getChannelByChannelName(channelName);
+			if (channel) {
+				if (channel->isClientInChannel(&client))
+					continue ;
+				if (!channel->checkForModeRestrictions(client, password,
+					[&](Client &client, Reply &response) { MessageServerToClient(client, response); }))
+					continue ;
+				channel->addClient(&client);
+				sendToChannelClients(channel, RPL_JOIN(client.getPrefix(), channel->getChannelName()));
+				sendNames(client, channel);
 			}
-			if (channelExists == false) {
-				Channel *newChannel = new Channel(channelName);
-				newChannel->setTimestamp();
+			else {
+				Channel *newChannel = createChannel(channelName);
 				newChannel->addClient(&client);
-				_channels.push_back(newChannel);
 				newChannel->setChOperator(&client);
 				//sends message to client that client is joined and operator
-				MessageServerToClient(client, RPL_JOIN(client.getNick(), channelName));
-				MessageServerToClient(client, RPL_NAMREPLY(client.getNick(), channelName, client.getNick()));
-				MessageServerToClient(client, RPL_ENDOFNAMES(client.getNick(), channelName));
-				return ;
+				MessageServerToClient(client, RPL_JOIN(client.getPrefix(), channelName));
+				sendNames(client, newChannel);
 			}
 		}
-		
 	}
 }
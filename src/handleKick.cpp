@@ -13,50 +13,37 @@
 #include "Server.hpp"
 #include "Channel.hpp"
 #include "response.hpp"
-#include <sstream>
 #include <algorithm>
 
 /*Kicks clients from channels, checks first if channel exists, then uses try / catch to account for potential
   errors such as "no operator", "user not in channel" or "user does not exist". Furthermore, checks if reason
-  is empty or only consists of whitespace and ':'. If this is the case, reason is treated as empty and the user's
-  nickname is passed to message function as "reason". If reaon is not empty, string manipulation is conducted in order
-  to remove any whitespace characters at the end of the string and potential ':' at beginning of string.*/
-void Server::handleKick(Client &client, std::string message)
+  is empty or only consists of whitespace. If this is the case, reason is treated as empty and the user's
+  nickname is passed to message function as "reason". If reason is not empty, trailing whitespace is removed.
+  A channel left without members by the kick is destroyed.*/
+void Server::handleKick(Client &client, const IrcMessage &msg)
 {
-	std::istringstream	iss(message);
-	std::string			command;
-	std::string			channelName;
-	std::string			nick;
-	std::string			reason;
-	std::string			kickMessage;
+	std::string			channelName(msg.param(0));
+	std::string			nick(msg.param(1));
+	std::string			reason(msg.param(2));
 	bool				reasonExist = false;
-	iss >> command;
-	iss >> channelName;
-	iss >> nick;
-	std::getline(iss, reason);
 
-	reason.erase(0, reason.find_first_not_of(' '));
-	if (!checkIfChannelExists(channelName))
+	Channel *channel = getChannelByChannelName(channelName);
+	if (!channel)
 	{
 		MessageServerToClient(client, ERR_NOSUCHCHANNEL(client.getNick(), channelName));
 		return;
 	}
-	if (!reason.empty() && !(std::all_of(reason.begin(), reason.end(), [](unsigned char ch) { return std::isspace(ch) || ch == ':'; }))) {
+	if (!reason.empty() && !(std::all_of(reason.begin(), reason.end(), [](unsigned char ch) { return std::isspace(ch); }))) {
 		reasonExist = true;
 		reason.erase(reason.find_last_not_of(" \n\r\t")+1);
-		if (reason[0] == ':')
-			reason.erase(0, 1);
 	}
 	try{
-		getChannelByChannelName(channelName)->setKick(&client, channelName, nick);
-		if (reasonExist == true)
-			kickMessage = RPL_KICK(client.getNick(), channelName, nick, reason);
-		else
-			kickMessage = RPL_KICK(client.getNick(), channelName, nick, nick);
-		for (Client *member : getChannelByChannelName(channelName)->getUsers()) {
-			MessageServerToClient(*member, kickMessage);
-		}
-			MessageServerToClient(*getClientByNickname(nick), kickMessage);
+		Client *target = getClientByNickname(nick);
+		channel->setKick(&client, target);
+		Reply kickMessage = RPL_KICK(client.getPrefix(), channelName, nick, reasonExist ? reason : nick);
+		sendToChannelClients(channel, kickMessage);
+		MessageServerToClient(*target, kickMessage);
+		removeClientFromChannel(channel, target);
 	}
 	catch (const Channel::ClientNotOperatorException &e) {
 		MessageServerToClient(client, ERR_CHANOPRIVSNEEDED(client.getNick(), channelName));
@@ -12,6 +12,7 @@
 
 #include "Channel.hpp"
 #include "Server.hpp"
+#include "response.hpp"
 #include <iostream>
 #include "Client.hpp"
 
@@ -47,8 +48,7 @@ std::string	Server::compressModes(const std::string& setModes)
   are filled in order to return respective message to client which modes were set for the channel.*/
 void	Server::executeModes(Client& client, Channel* channel)
 {
-	std::string					response;
-	char						currentSign;
+	char						currentSign = '\0';
 	int							i = 0;
 	std::string					setModes;
 	std::string					setParameters;
@@ -78,7 +78,7 @@ void	Server::executeModes(Client& client, Channel* channel)
 						i++;
 						break;
 					case 'l':
-						std::cout << "PARAMETER: " << parameters[i] << std::endl;
+						LOG(LEVEL_DEBUG, LOG_CHANNEL, "PARAMETER: " << parameters[i]);
 						channel->setUserLimit(std::stoi(parameters[i]));
 						setModes += "+l";
 						if (setParameters.empty())
@@ -90,7 +90,7 @@ void	Server::executeModes(Client& client, Channel* channel)
 					case 'o':  
 						toAddOperator = getClientByNickname(parameters[i]);
 						channel->setChOperator(toAddOperator);
-						std::cout << parameters[i] << " set as operator" << std::endl;
+						LOG(LEVEL_DEBUG, LOG_CHANNEL, parameters[i] << " set as operator");
 						setModes += "+o";
 						if (setParameters.empty())
 							setParameters += parameters[i];
@@ -148,9 +148,8 @@ void	Server::executeModes(Client& client, Channel* channel)
 		}
 	}
 	setModes = compressModes(setModes);
-	response = ":" + client.getNick() + " " + "Mode" + " " + channel->getChannelName() + " " + setModes;
+	Reply response = RPL_MODE(client.getPrefix(), channel->getChannelName(), setModes);
 	if (!setParameters.empty())
-		response += " " + setParameters;
-	for (Client *member : channel->getUsers())
-		MessageServerToClient(*member, response);
+		response.param(setParameters);
+	sendToChannelClients(channel, response);
 }
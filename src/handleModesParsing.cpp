@@ -17,7 +17,6 @@
 #include <algorithm>
 #include <iostream>
 #include <unordered_set>
-#include <sstream>
 
 
 /*Helper function of checkForValidModes, cheks if all strings of vector are all filled, if parameter for l mode only
@@ -29,7 +28,7 @@ bool	Server::checkValidParameter(int index, std::vector<std::string> parameter,
 	if ((std::all_of(parameter[index].begin(), parameter[index].end(), [](unsigned char ch) { return std::isspace(ch); }))
 		|| parameter[index].empty())
 	{
-		MessageServerToClient(client, ERR_NEEDMOREPARAMS(client.getNick()));
+		MessageServerToClient(client, ERR_NEEDMOREPARAMS(client.getNick(), "MODE"));
 		return (false);
 	}
 	if (mode == 'l' && !std::all_of(parameter[index].begin(), parameter[index].end(), ::isdigit))
@@ -40,7 +39,7 @@ bool	Server::checkValidParameter(int index, std::vector<std::string> parameter,
 			MessageServerToClient(client, ERR_NOTONCHANNEL(parameter[index], channel->getChannelName()));
 			return (false);
 		}
-		else if (!userIsMemberOfChannel(*potentialMember, channel->getChannelName())) {
+		else if (!channel->isClientInChannel(potentialMember)) {
 			MessageServerToClient(client, ERR_NOTONCHANNEL(parameter[index], channel->getChannelName()));
 			return (false);
 		}
@@ -51,20 +50,18 @@ bool	Server::checkValidParameter(int index, std::vector<std::string> parameter,
 /*First checks if any invalid characters are occuring in the modes string and returns a respective message if this
   is the case. Otherwise counts the occurence of k, l and o within the modes string, only counting for the minus part
   the o occurence as for the other modes no parameters are expected for the minus part. This is how the amount of
-  needed parameters can be determined in the rest of the message. Then iterates further with iss using the parameter
-  amount and stores the remaining content of the message in the parameter vector. Modes and parameters are stored in
+  needed parameters can be determined in the rest of the message. Then takes the parameter amount from the parsed
+  message parameters (following the modes string) and stores them in the parameter vector. Modes and parameters are stored in
   respective data fields of the channel class object for later usage within the exectueModes function.*/
-bool	Server::checkForValidModes(const std::string& message, Client& client, Channel* channel)
+bool	Server::checkForValidModes(const IrcMessage &msg, Client& client, Channel* channel)
 {
-	std::string 		modes;
+	std::string 		modes(msg.param(1));
 	std::string			response;
 	char				currentSign = '\0';
 	int					neededParameterCount = 0;
 	int					index = 0;
 	std::unordered_set<char> allowedChars = {'+', '-', 'i', 'k', 'l', 'o', 't'};
 	
-	std::istringstream	iss(message);
-	iss >> modes;
 	for (char c : modes) {
 		if (allowedChars.find(c) == allowedChars.end()) {
 			MessageServerToClient(client, ERR_UNKNOWNMODE(client.getNick(), c));
@@ -86,7 +83,7 @@ bool	Server::checkForValidModes(const std::string& message, Client& client, Chan
 	if (neededParameterCount > 0) {
 		std::vector<std::string> parameter(neededParameterCount);
 		for (int i = 0; i < neededParameterCount; i++)
-			iss >> parameter[i];
+			parameter[i] = msg.param(i + 2);
 		for (char c : modes) {
 			if (c == '+' || c == '-')
 				currentSign = c;
@@ -118,21 +115,21 @@ bool	Server::checkForValidModes(const std::string& message, Client& client, Chan
 }
 
 /*Main function for handling parsing and execution of /mode and /mode +/- arguments.
-  First checks if message string is empty or only consists of white space characters. If this is the case, it is expected that only the
+  First checks if a modes parameter was given. If this is not the case, it is expected that only the
   /mode command without arguments is passed by client. It is then checked if the channel exists and if the user is member of the channel
   in order to reply with the respective modes set for the channel and the channel creation timestamp (as done in libera chat). If the channel
   does not exist, a respective message is sent to user.
-  If the message string is not empty, it is first checked if the channelName is actually containing a '#' at 0 index. If this is not the case,
+  If modes are given, it is first checked if the channelName is actually containing a '#' at 0 index. If this is not the case,
   the parsed channel name is actually the user name and the /mode command is the initial command sent automatically by client when logging in
   to the server. This case is ignored for the time being. Otherwise, if the channelName is indeed starting with '#' it is furthermore checked
   if the user has channel operator rights and if the modes given to the command are valid and - if this is the case - the information is passed to the executeModes function.*/
-void Server::handleMode(Client& client, const std::string& channelName, const std::string& message)
+void Server::handleMode(Client& client, const IrcMessage &msg)
 {
-	Channel* channel;
-	if ((std::all_of(message.begin(), message.end(), [](unsigned char ch) { return std::isspace(ch); })) || message.empty()) {
-		if (channelExists(channelName)) {
-			if (userIsMemberOfChannel(client, channelName)) {
-				channel = getChannelByChannelName(channelName);
+	std::string channelName(msg.param(0));
+	Channel* channel = getChannelByChannelName(channelName);
+	if (msg.param(1).empty()) {
+		if (channel) {
+			if (channel->isClientInChannel(&client)) {
 				MessageServerToClient(client, RPL_CHANNELMODEIS(client.getNick(), channelName, channel->getMode()));
 				MessageServerToClient(client, RPL_CREATIONTIME(client.getNick(), channelName, channel->getTimestamp()));
 			}
@@ -143,12 +140,15 @@ void Server::handleMode(Client& client, const std::string& channelName, const st
 	else {
 		if (channelName[0] != '#')
 			return ;
-		channel = getChannelByChannelName(channelName);
+		if (!channel) {
+			MessageServerToClient(client, ERR_NOSUCHCHANNEL(client.getNick(), channelName));
+			return ;
+		}
 		if (!channel->isChannelOperator(&client)) {
 			MessageServerToClient(client, ERR_CHANOPRIVSNEEDED(client.getNick(), channelName));
 			return ;
 		}
-		if (checkForValidModes(message, client, channel))
+		if (checkForValidModes(msg, client, channel))
 			executeModes(client, channel);
 	}
 }
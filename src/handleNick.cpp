@@ -12,28 +12,48 @@
 
 #include "Server.hpp"
 #include "response.hpp"
+#include <cctype>
+#include <cstring>
 
-void Server::handleNick(Client &client, std::string nick)
+/*RFC 2812 nickname grammar, with NICKLEN (MAX_NICK_LENGTH) instead of 9 characters:
+  ( letter / special ) *( letter / digit / special / "-" ), special being one of []\`_^{|}.
+  Keeps ',' (target lists), '!', '@' (the nick!user@host prefix), '#' and ':' out of nicks.*/
+static bool	isValidNick(const std::string &nick)
 {
-	std::string oldNick = client.getNick();
+	auto isSpecial = [](char c) { return (c != '\0' && std::strchr("[]\\`_^{|}", c) != nullptr); };
 
-	if (clientExists(nick))
-		MessageServerToClient(client, ERR_NICKNAMEINUSE(oldNick, nick));
+	if (nick.empty() || nick.size() > MAX_NICK_LENGTH)
+		return (false);
+	if (!std::isalpha(static_cast<unsigned char>(nick[0])) && !isSpecial(nick[0]))
+		return (false);
+	for (char c : nick)
+	{
+		if (!std::isalnum(static_cast<unsigned char>(c)) && !isSpecial(c) && c != '-')
+			return (false);
+	}
+	return (true);
+}
+
+void Server::handleNick(Client &client, const IrcMessage &msg)
+{
+	std::string nick(msg.param(0));
+	Client *owner = getClientByNickname(nick);
+
+	if (nick.empty())
+		MessageServerToClient(client, ERR_NONICKNAMEGIVEN());
+	else if (!isValidNick(nick))
+		MessageServerToClient(client, ERR_ERRONEUSNICKNAME(client.getNick(), nick));
+	else if (owner != nullptr && owner != &client)
+		MessageServerToClient(client, ERR_NICKNAMEINUSE(client.getNick(), nick));
 	else
 	{
-		client.setNick(nick);
-		for (Channel *channel : _channels)
-		{
-			if (channel->isClientInChannel(&client))
-			{
-					for (Client *member : channel->getUsers())
-					{
-						if (member->getNick() != client.getNick())
-							MessageServerToClient(*member, RPL_NICK(oldNick, client.getUsername(), client.getNick()));
-					}
-			}
-		}
-		MessageServerToClient(client, RPL_NICK(oldNick, client.getUsername(), client.getNick()));
+		// built before the rename, the line carries the old prefix
+		Reply reply = RPL_NICK(client.getPrefix(), nick);
+		registerNick(client, nick);
+		for (Channel *channel : client.getJoinedChannels())
+			channel->bumpVersion();
+		sendToNeighbors(client, reply);
+		MessageServerToClient(client, reply);
 		client.setNickOK(true);
 	}
 }
\ No newline at end of file
@@ -11,40 +11,25 @@
 /* **************************************************************************************** */
 
 #include "Server.hpp"
-#include "Channel.hpp"
-#include <sstream>
+#include "response.hpp"
 
-struct Parse
+/*OPER <name> <password>: grants operator rights (needed for STATS) if the password matches
+  --oper-password. The name is not checked, there is a single operator password. Without the
+  option OPER is refused for everyone.*/
+void Server::handleOper(Client &client, const IrcMessage &msg)
 {
-	std::string command = "";
-	std::string channelName = "";
-	std::string nickName = "";
-	std::string userName = "";
-	std::string message = "";
-	bool toAll = false;
-	int receiverFD = -1;
-};
-
-Parse parseMessage(const std::string& input) {
-	Parse				newRequest;
-	std::istringstream	iss(input);
-	std::string			temp;
-
-	iss >> newRequest.command;
-	if (iss >> temp) {
-		if (!temp.empty() && temp[0] == '#')
-			newRequest.channelName = temp;
-		else
-			newRequest.message = temp;
+	if (_config.operPassword.empty())
+	{
+		MessageServerToClient(client, ERR_NOOPERHOST(client.getNick()));
+		return;
 	}
-	std::string remainingMessage;
-	std::getline(iss, remainingMessage);
-	if (!remainingMessage.empty()) {
-		if (remainingMessage[0] == ' ')
-			remainingMessage = remainingMessage.substr(1);
-		if (!newRequest.message.empty())
-			newRequest.message += " ";
-		newRequest.message += remainingMessage;
+	if (msg.param(1) != _config.operPassword)
+	{
+		LOG(LEVEL_WARN, LOG_CLIENT, "failed OPER attempt by " << client.getNick());
+		MessageServerToClient(client, ERR_PASSWDMISMATCH(client.getNick()));
+		return;
 	}
-	return (newRequest);
+	client.setOperator(true);
+	LOG(LEVEL_INFO, LOG_CLIENT, client.getNick() << " is now an operator");
+	MessageServerToClient(client, RPL_YOUREOPER(client.getNick()));
 }
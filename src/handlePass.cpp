@@ -13,22 +13,19 @@
 #include "Server.hpp"
 #include "Channel.hpp"
 #include "response.hpp"
-#include <algorithm>
 
-void Server::handlePass(Client &client, const std::vector<std::string>& tokens, int index)
+void Server::handlePass(Client &client, const IrcMessage &msg)
 {
 	std::string response;
-	if (tokens[index + 1] == _passwd)
+	if (msg.param(0) == _passwd)
 	{
 		MessageServerToClient(client, RPL_PASSWDOK());
 		client.setPasswdOK(true);
 	}
 	else
 	{
-		std::cout << "wrong password" << std::endl;
+		LOG(LEVEL_INFO, LOG_CLIENT, "wrong password on fd " << client.getFd());
 		MessageServerToClient(client, ERR_PASSWDMISMATCH(client.getNick()));
-		close(client.getFd());
-		_clients.erase(std::remove_if(_clients.begin(), _clients.end(),
-		[&](Client* c) { return c->getFd() == client.getFd(); }), _clients.end());
+		disconnectClient(client, DISCONNECT_BAD_PASSWORD);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Server.hpp"
+#include "response.hpp"
+
+/*Answers a PING of the client with a PONG carrying the same token*/
+void Server::handlePing(Client &client, const IrcMessage &msg)
+{
+	MessageServerToClient(client, RPL_PONG(msg.param(0)));
+}
+
+/*Answer to a keepalive PING of the server. Nothing to do, every received line already counts as
+  activity (see handleClientMessage).*/
+void Server::handlePong(Client &client, const IrcMessage &msg)
+{
+	(void)client;
+	(void)msg;
+}
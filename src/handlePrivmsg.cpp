@@ -15,34 +15,89 @@
 #include "Channel.hpp"
 #include "response.hpp"
 
-void Server::handlePrivmsg(Client &client, const std::string channelNameOrNick,  std::string &message)
-{    
-    message.erase(0, message.find_first_not_of(' '));
-	message.erase(message.find_last_not_of(" \n\r\t")+1);
-    if (channelNameOrNick[0] == '#')
-    {
-        for (Channel *channel : _channels)
-        {
-            if (channel->getChannelName() == channelNameOrNick)
-            {
-                for (Client *_client : channel->getUsers())
-                {
-                    if (_client != &client)
-                    {
-                        MessageServerToClient(*_client, RPL_PRIVMSG(client.getNick(), channelNameOrNick, message));                    
-                    }
-                }            
-            }
-        }
-    }
-    else
-    {
-        for (Client *_client : _clients)
-        {
-            if (_client->getNick() == channelNameOrNick)
-            {
-                MessageServerToClient(*_client, RPL_PRIVMSG(client.getNick(), _client->getNick(), message));                    
-            }
-        }  
-    }
+/*
+	PRIVMSG and NOTICE take a comma separated list of up to MAX_TARGETS channels and nicks
+	(advertised as TARGMAX). Each target is looked up in the name indexes. A recipient reached
+	through several targets gets the text only once, through the first one: every message takes
+	a new broadcast epoch and marks its recipients with it (as Server::sendToNeighbors does).
+	The line is formatted once per target that still has recipients, and all of their queues
+	share it. NOTICE never causes error replies.
+*/
+
+void Server::handlePrivmsg(Client &client, const IrcMessage &msg) { deliverMessage(client, msg, false); }
+
+void Server::handleNotice(Client &client, const IrcMessage &msg) { deliverMessage(client, msg, true); }
+
+void Server::deliverMessage(Client &client, const IrcMessage &msg, bool notice)
+{
+	std::string_view	targets = msg.param(0);
+	uint64_t			epoch = ++_broadcastEpoch;
+	int					count = 0;
+	size_t				start = 0;
+
+	while (start <= targets.size())
+	{
+		size_t end = targets.find(',', start);
+		if (end == std::string_view::npos)
+			end = targets.size();
+		std::string_view target = targets.substr(start, end - start);
+		start = end + 1;
+		if (target.empty())
+			continue;
+		if (++count > MAX_TARGETS)
+		{
+			if (!notice)
+				MessageServerToClient(client, ERR_TOOMANYTARGETS(client.getNick(), target));
+			return;
+		}
+		deliverToTarget(client, target, msg.param(1), notice, epoch);
+	}
+}
+
+/*Queues the text for the recipients of one target which were not reached by the message yet.
+  The sender does not get its own channel messages, a message to its own nick is delivered.*/
+void Server::deliverToTarget(Client &client, std::string_view target, std::string_view text, bool notice, uint64_t epoch)
+{
+	SharedLine	line;
+	size_t		recipients = 0;
+	auto format = [&](const std::string &name) {
+		Reply reply = notice ? RPL_NOTICE(client.getPrefix(), name, text) : RPL_PRIVMSG(client.getPrefix(), name, text);
+		LOG(LEVEL_TRACE, LOG_PROTO, ">> " << reply.view());
+		return (reply.line());
+	};
+
+	if (target[0] == '#')
+	{
+		Channel *channel = getChannelByChannelName(target);
+		if (channel == nullptr)
+		{
+			if (!notice)
+				MessageServerToClient(client, ERR_NOSUCHNICK(client.getNick(), target));
+			return;
+		}
+		for (Client *member : channel->getUsers())
+		{
+			if (member == &client || member->getBroadcastMark() == epoch || member->getState() == DISCONNECTED)
+				continue;
+			member->setBroadcastMark(epoch);
+			if (!line)
+				line = format(channel->getChannelName());
+			queueLine(*member, line);
+			recipients++;
+		}
+		if (recipients != 0)
+			_metrics.broadcast(recipients);
+		return;
+	}
+	Client *recipient = getClientByNickname(target);
+	if (recipient == nullptr)
+	{
+		if (!notice)
+			MessageServerToClient(client, ERR_NOSUCHNICK(client.getNick(), target));
+		return;
+	}
+	if (recipient->getBroadcastMark() == epoch || recipient->getState() == DISCONNECTED)
+		return;
+	recipient->setBroadcastMark(epoch);
+	queueLine(*recipient, format(recipient->getNick()));
 }
@@ -12,18 +12,15 @@
 
 #include "Server.hpp"
 #include "Channel.hpp"
+#include "response.hpp"
 
-void Server::handleQuit(Client &client, std::string message)
+/*The neighbors get one QUIT line each, the client an ERROR before its link is closed*/
+void Server::handleQuit(Client &client, const IrcMessage &msg)
 {
-    std::cout << client.getNick() << " Quitted!!. Message = " << message << std::endl;
-    for (Channel *channel : _channels)
-    {
-        for (Client *_client : channel->getUsers())
-        {
-            if (_client == &client)
-            {
-                channel->removeClient(_client);
-            }
-        }
-    }
+    std::string reason = msg.param(0).empty() ? "Client Quit" : "Quit: " + std::string(msg.param(0));
+
+    LOG(LEVEL_INFO, LOG_CLIENT, client.getNick() << " quit: " << msg.param(0));
+    MessageServerToClient(client, ERR_CLOSINGLINK(client.getNick(), reason));
+    quitClient(client, reason);
+    disconnectClient(client, DISCONNECT_QUIT);
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Server.hpp"
+#include "response.hpp"
+
+/*STATS [query]: server metrics for operators, see writeStats for the known queries*/
+void Server::handleStats(Client &client, const IrcMessage &msg)
+{
+	if (!client.isOperator())
+	{
+		MessageServerToClient(client, ERR_NOPRIVILEGES(client.getNick()));
+		return;
+	}
+	std::string_view query = msg.param(0);
+	writeStats(client, query.empty() ? '*' : query[0]);
+}
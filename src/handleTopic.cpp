@@ -13,36 +13,35 @@
 #include "Server.hpp"
 #include "Channel.hpp"
 #include "response.hpp"
-#include <sstream>
 
 /*Checks if conditions for setting topic are met and if this is the case, sets respective
   topic for channel. First trims topic message string end from by any white space, then checks if 
   channel exists, and in the setTopic function varifies if client is part of the channel
   and if the topic operator only mode is active. Catches respective exceptions thrown by
-  setTopic function. Broadcast topic change to all members of the channel*/
-void Server::handleTopic(Client &client, const std::string& channelName, std::string message)
+  setTopic function and stops on error. Broadcast topic change to all members of the channel*/
+void Server::handleTopic(Client &client, const IrcMessage &msg)
 {
-	std::istringstream iss(message);
-	std::getline(iss, message);
+	std::string channelName(msg.param(0));
+	std::string message(msg.param(1));
 
-	message.erase(0, message.find_first_not_of(' '));
 	message.erase(message.find_last_not_of(" \n\r\t")+1);
 	
-	if (!checkIfChannelExists(channelName))
+	Channel *channel = getChannelByChannelName(channelName);
+	if (!channel)
 	{
 		MessageServerToClient(client, ERR_NOSUCHCHANNEL(client.getNick(), channelName));
 		return;
 	}
 	try{
-		getChannelByChannelName(channelName)->setTopic(&client, message);
+		channel->setTopic(&client, message);
 	}
 	catch (const Channel::ClientNotOperatorException &e) {
 		MessageServerToClient(client, ERR_CHANOPRIVSNEEDED(client.getNick(), channelName));
+		return;
 	}
 	catch (const Channel::ClientNotInChannelException &e) {
 		MessageServerToClient(client, ERR_NOTONCHANNEL(client.getNick(), channelName));
+		return;
 	}
-	std::string response = ":" + client.getNick() + " " + "TOPIC " + channelName + " " + message;
-	for (Client *member : getChannelByChannelName(channelName)->getUsers())
-		MessageServerToClient(*member, RPL_TOPIC(client.getNick(), channelName, message));
+	sendToChannelClients(channel, RPL_TOPIC(client.getPrefix(), channelName, message));
 }
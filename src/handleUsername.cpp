@@ -17,8 +17,8 @@
 /*
  * Handle the USER message
  */
-void Server::handleUserName(Client &client, std::vector<std::string> tokens, int index)
+void Server::handleUserName(Client &client, const IrcMessage &msg)
 {
-	client.setUsername(tokens[index + 1]);
+	client.setUsername(std::string(msg.param(0)));
 	client.setUserNameOK(true);
 }
\ No newline at end of file
@@ -25,6 +25,21 @@ int printErrorMessage(int errorFlag)
 	if (errorFlag == 2)
 		std::cout << "Error." << std::endl
 				  << "Input number is out of range. Please try again." << std::endl;
+	if (errorFlag == 3)
+		std::cout << "Error." << std::endl
+				  << "Invalid option. Available options:" << std::endl
+				  << "  --io=epoll|poll|io_uring    event backend (default epoll)" << std::endl
+				  << "  --threads=N                 event loops, 1 - " << MAX_EVENT_LOOPS << " (default 1)" << std::endl
+				  << "  --max-clients=N             open connections, 1 - " << MAX_CLIENTS_LIMIT << " (default 999)" << std::endl
+				  << "  --backlog=N                 listen backlog, 1 - " << MAX_LISTEN_BACKLOG << " (default 1024)" << std::endl
+				  << "  --ping-interval=SECONDS     idle time until a PING is sent (default 120)" << std::endl
+				  << "  --ping-timeout=SECONDS      time to answer a PING (default 60)" << std::endl
+				  << "  --register-timeout=SECONDS  time to complete the registration (default 30)" << std::endl
+				  << "  --oper-password=PASSWORD    enables OPER (needed for STATS)" << std::endl
+				  << "  --metrics-port=N            Prometheus metrics on 127.0.0.1:N/metrics, 1024 - 65535" << std::endl
+				  << "  --capture=FILE              records the inbound traffic for ircreplay" << std::endl
+				  << "  --log-level=LEVEL           trace|debug|info|warn|error|off for all categories (default info)" << std::endl
+				  << "  --log=CATEGORY:LEVEL,...    level per category: core, net, proto, channel, client" << std::endl;
 	return (1);
 }
 
@@ -44,22 +59,90 @@ int checkValidPort(std::string port)
 	return portNo;
 }
 
+/*Parses a decimal number in the range [min, max] into result. Returns false if value is not a
+  number or out of range.*/
+bool parseNumber(const std::string &value, int min, int max, int &result)
+{
+	if (value.empty() || value.length() > 9)
+		return false;
+	for (size_t i = 0; i < value.length(); i++)
+	{
+		if (!isdigit(value[i]))
+			return false;
+	}
+	int number = std::stoi(value);
+	if (number < min || number > max)
+		return false;
+	result = number;
+	return true;
+}
+
+/*Parses the optional --option=value arguments following port and password. Returns false
+  on unknown options or invalid values.*/
+bool parseOptions(int argc, char **argv, ServerConfig &config)
+{
+	for (int i = 3; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+		size_t eq = arg.find('=');
+		if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos)
+			return false;
+		std::string key = arg.substr(2, eq - 2);
+		std::string value = arg.substr(eq + 1);
+		if (key == "io" && (value == "epoll" || value == "poll" || value == "io_uring"))
+			config.ioBackend = value;
+		else if (key == "threads" && parseNumber(value, 1, MAX_EVENT_LOOPS, config.threads))
+			continue;
+		else if (key == "max-clients" && parseNumber(value, 1, MAX_CLIENTS_LIMIT, config.maxClients))
+			continue;
+		else if (key == "backlog" && parseNumber(value, 1, MAX_LISTEN_BACKLOG, config.listenBacklog))
+			continue;
+		else if (key == "ping-interval" && parseNumber(value, 1, MAX_TIMEOUT_SECONDS, config.pingInterval))
+			continue;
+		else if (key == "ping-timeout" && parseNumber(value, 1, MAX_TIMEOUT_SECONDS, config.pingTimeout))
+			continue;
+		else if (key == "register-timeout" && parseNumber(value, 1, MAX_TIMEOUT_SECONDS, config.registrationTimeout))
+			continue;
+		else if (key == "oper-password" && !value.empty())
+			config.operPassword = value;
+		else if (key == "metrics-port" && parseNumber(value, 1024, 65535, config.metricsPort))
+			continue;
+		else if (key == "capture" && !value.empty())
+			config.capturePath = value;
+		else if (key == "log-level" && Logger::configure("all:" + value))
+			continue;
+		else if (key == "log" && Logger::configure(value))
+			continue;
+		else
+			return false;
+	}
+	return true;
+}
+
 int main(int argc, char **argv)
 {
-	if (argc != 3)
+	ServerConfig config;
+
+	if (argc < 3)
 		return (printErrorMessage(0));
 	int port = checkValidPort(argv[1]);
 	if (!port)
 		return (printErrorMessage(1));
+	if (!parseOptions(argc, argv, config))
+		return (printErrorMessage(3));
 	Server server(port, argv[2]);
+	server.setConfig(config);
+	Logger::start();
 	try
 	{
 		server.runServer();
 	}
 	catch (const std::exception &e)
 	{
+		Logger::stop();
 		std::cerr << e.what() << '\n';
 		return (1);
 	}
+	Logger::stop();
 	return 0;
 }
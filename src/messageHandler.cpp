@@ -12,124 +12,147 @@
 
 #include "Server.hpp"
 #include "response.hpp"
-#include <sstream>
-#include <regex>
 
 /*
- * Handle events on the server
+ * Queue a message for the client, the queue is written to the socket at the end of the
+ * current event batch (or once the socket is writable again). Clients whose queue
+ * overflows are disconnected by their event loop. The reply's own buffer is queued (see
+ * Reply::line), the same reply may be passed on to further clients afterwards.
  */
-void Server::MessageServerToClient(Client client, const std::string &message)
+void Server::MessageServerToClient(Client &client, Reply &reply)
 {
-	std::cout << ">> " << message << std::endl;
-	std::string formattedMessage = message + "\r\n";
-	if (send(client.getFd(), formattedMessage.c_str(), formattedMessage.size(), 0) == -1)
-	{
-		perror("Error sending message to client");
-	}
+	if (client.getState() == DISCONNECTED)
+		return;
+	LOG(LEVEL_TRACE, LOG_PROTO, ">> " << reply.view());
+	queueLine(client, reply.line());
 }
 
 /*
-	Handle messages from the client
-*/
-void Server::handleClientMessage(Client &client, const std::string &message)
+ * Send the same message to every member of the channel except 'except' (may be nullptr). The line
+ * is formatted once, all member queues share the buffer.
+ */
+void Server::sendToChannelClients(Channel *channel, Reply &reply, Client *except)
 {
-	std::cout << "<< " << message << std::endl;
-	if (client.getState() == REGISTERING)
+	LOG(LEVEL_TRACE, LOG_PROTO, ">> " << channel->getChannelName() << " " << reply.view());
+	const SharedLine &line = reply.line();
+	size_t recipients = 0;
+	for (Client *member : channel->getUsers())
 	{
-		std::vector<std::string> tokens = SplitString(message);
-		if (tokens.size() < 2)
+		if (member != except && member->getState() != DISCONNECTED)
 		{
-			MessageServerToClient(client, RPL_NICKREQUEST());
-			return;
-		}
-		int i = 0;
-		for (auto &token : tokens)
-		{
-			if (token == "CAP")
-				handleCAPs(client, tokens, i);
-			if (token == "PASS")
-				handlePass(client, tokens, i);
-			if (token == "USER")
-				handleUserName(client, tokens, i);
-			if (token == "NICK")
-			{
-				handleNick(client, tokens[i + 1]);
-			}
-			i++;
+			queueLine(*member, line);
+			recipients++;
 		}
 	}
-	else
-	{
-		std::string args[3];
-		std::istringstream iss(message);
-		iss >> args[0];
+	_metrics.broadcast(recipients);
+}
 
-		if (args[0] == "PING")
-		{
-			iss >> args[1];
-			MessageServerToClient(client, "PONG " + args[1]);
-		}
-		else if (args[0] == "JOIN")
-		{
-			iss >> args[1];
-			iss >> args[2];
-			handleJoin(client, args[1], args[2]);
-		}
-		else if (args[0] == "PRIVMSG")
-		{
-			iss >> args[1];
-			std::getline(iss, args[2]);
-			handlePrivmsg(client, args[1], args[2]);
-		}
-		else if (args[0] == "NICK")
-		{
-			iss >> args[1];
-			handleNick(client, args[1]);
-		}
-		else if (args[0] == "MODE")
-		{
-			iss >> args[1];
-			std::getline(iss, args[2]);
-			handleMode(client, args[1], args[2]);
-		}
-		else if (args[0] == "TOPIC")
-		{
-			iss >> args[1];
-			std::getline(iss, args[2]);
-			handleTopic(client, args[1], args[2]);
-		}
-		else if (args[0] == "KICK")
-		{
-			handleKick(client, message);
-		}
-		else if (args[0] == "INVITE")
-		{
-			handleInvite(client, message);
-		}
-		else if (args[0] == "QUIT")
+/*
+ * Send the message once to every client sharing at least one channel with 'client' (not to the
+ * client itself). A client in several of these channels is reached once: every call takes a new
+ * broadcast epoch and a member is skipped if its mark already holds it, so no temporary set of
+ * recipients is built.
+ */
+void Server::sendToNeighbors(Client &client, Reply &reply)
+{
+	uint64_t epoch = ++_broadcastEpoch;
+	size_t recipients = 0;
+
+	client.setBroadcastMark(epoch);
+	for (Channel *channel : client.getJoinedChannels())
+	{
+		for (Client *member : channel->getUsers())
 		{
-			handleQuit(client, message);
+			if (member->getBroadcastMark() == epoch || member->getState() == DISCONNECTED)
+				continue;
+			member->setBroadcastMark(epoch);
+			if (recipients == 0)
+				LOG(LEVEL_TRACE, LOG_PROTO, ">> neighbors of " << client.getNick() << " " << reply.view());
+			queueLine(*member, reply.line());
+			recipients++;
 		}
 	}
+	_metrics.broadcast(recipients);
+}
+
+/*
+ * Hand an already terminated line to the transport owning the client's connection (its event loop
+ * or a loopback transport). Only called on the main loop.
+ */
+void Server::queueLine(Client &client, const SharedLine &line)
+{
+	client.getTransport()->postFromMain({LOOP_SEND, &client, line});
 }
 
 /*
- * Split a string by a delimiter
+ * Messages queued by the event loops for the main loop: new connections, received lines and
+ * closed connections.
  */
-std::vector<std::string> Server::SplitString(const std::string &str)
+void Server::handleLoopMessage(const LoopMessage &message)
+{
+	Client &client = *message.client;
+
+	if (message.type == LOOP_LINE)
+		handleClientMessage(client, *message.line, message.receivedAt);
+	else if (message.type == LOOP_LINE_TOO_LONG)
+		inputTooLong(client);
+	else if (message.type == LOOP_CONNECT)
+		clientConnected(client);
+	else if (message.type == LOOP_DISCONNECT)
+		clientClosed(client);
+}
+
+void Server::inputTooLong(Client &client)
+{
+	MessageServerToClient(client, ERR_INPUTTOOLONG(client.getNick()));
+}
+
+/*
+	Handle messages from the client. The line is parsed once, the command is looked up in the
+	command table (see commandTable.cpp) and the parsed message is passed on to its handler after
+	checking the registration state and the amount of parameters. Lines of disconnected clients
+	which were already read are dropped. Every line counts as activity for the keepalive timer and
+	answers a pending PING. Handled commands are counted, the time from receivedAt (0 if unknown)
+	until the main loop has queued the replies is recorded per command by recordLatencies. With
+	--capture every line is recorded before it is parsed.
+*/
+void Server::handleClientMessage(Client &client, std::string_view line, uint64_t receivedAt)
 {
-	std::vector<std::string> tokens;
-	std::regex re("\\s+");
-	std::sregex_token_iterator it(str.begin(), str.end(), re, -1);
-	std::sregex_token_iterator end;
+	IrcMessage	msg;
 
-	while (it != end)
+	if (client.getState() == DISCONNECTED)
+		return;
+	client.setLastActivity(_timers.getNowMs());
+	client.setPingSent(0);
+	LOG(LEVEL_TRACE, LOG_PROTO, "<< " << line);
+	if (_capture != nullptr)
+		captureTraffic(CAPTURE_LINE, client, line, receivedAt);
+	if (!parseIrcMessage(line, msg))
+		return;
+	const CommandEntry *command = findCommand(msg.command);
+	if (command == nullptr)
 	{
-		if (!it->str().empty())
-		{
-			tokens.push_back(*it);
-		}
-		++it;
+		_metrics.commandHandled(MAX_COMMANDS);
+		MessageServerToClient(client, ERR_UNKNOWNCOMMAND(client.getNick(), std::string(msg.command)));
+		return;
+	}
+	unsigned state = (client.getState() == REGISTERED) ? ALLOW_REGISTERED : ALLOW_REGISTERING;
+	if (!(command->allowedStates & state))
+	{
+		if (state == ALLOW_REGISTERING)
+			MessageServerToClient(client, ERR_NOTREGISTERED(client.getNick()));
+		else
+			MessageServerToClient(client, ERR_ALREADYREGISTRED(client.getNick()));
+		return;
+	}
+	if (msg.paramCount < command->minParams)
+	{
+		MessageServerToClient(client, ERR_NEEDMOREPARAMS(client.getNick(), std::string(command->name)));
+		return;
 	}
-	return tokens;
+	int index = getCommandIndex(command);
+	_metrics.commandHandled(index);
+	(this->*(command->handler))(client, msg);
+	if (receivedAt != 0)
+		_latencySamples.push_back({index, receivedAt});
 }
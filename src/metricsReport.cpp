@@ -0,0 +1,194 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "Server.hpp"
+#include "response.hpp"
+
+const double	LATENCY_QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+Metrics &Server::getMetrics() { return (_metrics); }
+
+/*Records the latency of the commands handled in this main loop iteration: receiving, handling
+  and queueing the replies. Called after the main loop flushed its send queues, but the write
+  itself is not covered: with io_uring the flush only prepares the SENDMSG requests, and replies
+  for clients of other loops are written by those loops afterwards.*/
+void Server::recordLatencies()
+{
+	if (_latencySamples.empty())
+		return;
+	uint64_t now = Metrics::monotonicMicros();
+	for (const auto &sample : _latencySamples)
+		_metrics.getLatency(sample.first).record(now > sample.second ? now - sample.second : 0);
+	_latencySamples.clear();
+}
+
+static void	writeHeader(std::string &out, const char *name, const char *type, const char *help)
+{
+	out += std::string("# HELP ircserv_") + name + " " + help + "\n";
+	out += std::string("# TYPE ircserv_") + name + " " + type + "\n";
+}
+
+static void	writeValue(std::string &out, const char *name, const std::string &labels, uint64_t value)
+{
+	out += std::string("ircserv_") + name;
+	if (!labels.empty())
+		out += "{" + labels + "}";
+	out += " " + std::to_string(value) + "\n";
+}
+
+static std::string	commandName(int index)
+{
+	return (index == MAX_COMMANDS ? "unknown" : getCommandEntry(index).name);
+}
+
+/*All metrics in the Prometheus text exposition format, per event loop where they are counted by
+  the loops. Called by the admin endpoint thread, everything read here is atomic.*/
+void Server::writePrometheus(std::string &out) const
+{
+	writeHeader(out, "uptime_seconds", "gauge", "Seconds since the server started.");
+	writeValue(out, "uptime_seconds", "", (TimerWheel::monotonicMs() - _metrics.getStartedAt()) / 1000);
+	writeHeader(out, "connections", "gauge", "Open client connections.");
+	writeValue(out, "connections", "", _connections.load(std::memory_order_relaxed));
+
+	struct LoopCounter { const char *name; const char *type; const char *help; };
+	static const LoopCounter loopCounters[] = {
+		{"accepted_total", "counter", "Accepted connections."},
+		{"rejected_total", "counter", "Connections refused because the server was full."},
+		{"accept_rate", "gauge", "Connections accepted per second."},
+		{"received_bytes_total", "counter", "Bytes read from client sockets."},
+		{"sent_bytes_total", "counter", "Bytes written to client sockets."},
+		{"sendq_bytes", "gauge", "Bytes waiting in the send queues."},
+		{"sendq_peak_bytes", "gauge", "Largest send queue of a single client so far."},
+	};
+	for (size_t counter = 0; counter < sizeof(loopCounters) / sizeof(loopCounters[0]); counter++)
+	{
+		writeHeader(out, loopCounters[counter].name, loopCounters[counter].type, loopCounters[counter].help);
+		for (const EventLoop *loop : _loops)
+		{
+			const LoopStats &stats = loop->getStats();
+			uint64_t values[] = {loop->getAcceptedTotal(), loop->getRejectedTotal(), loop->getAcceptRate(),
+				stats.bytesIn.load(std::memory_order_relaxed), stats.bytesOut.load(std::memory_order_relaxed),
+				stats.queuedBytes.load(std::memory_order_relaxed), stats.queuePeak.load(std::memory_order_relaxed)};
+			writeValue(out, loopCounters[counter].name, "loop=\"" + std::to_string(loop->getId()) + "\"", values[counter]);
+		}
+	}
+
+	writeHeader(out, "commands_total", "counter", "Handled commands.");
+	for (int i = 0; i < getCommandCount(); i++)
+		writeValue(out, "commands_total", "command=\"" + commandName(i) + "\"", _metrics.getCommands(i));
+	writeValue(out, "commands_total", "command=\"unknown\"", _metrics.getCommands(MAX_COMMANDS));
+	writeHeader(out, "broadcasts_total", "counter", "Lines sent to the members of a channel.");
+	writeValue(out, "broadcasts_total", "", _metrics.getBroadcasts());
+	writeHeader(out, "fanout_messages_total", "counter", "Lines queued for channel members by broadcasts.");
+	writeValue(out, "fanout_messages_total", "", _metrics.getFanout());
+	writeHeader(out, "disconnects_total", "counter", "Closed sessions by reason.");
+	for (int i = 0; i < DISCONNECT_REASONS; i++)
+	{
+		disconnectReason reason = static_cast<disconnectReason>(i);
+		writeValue(out, "disconnects_total", std::string("reason=\"") + Metrics::getReasonName(reason) + "\"",
+			_metrics.getDisconnects(reason));
+	}
+	writeHeader(out, "log_dropped_total", "counter", "Log records dropped because the log ring was full.");
+	writeValue(out, "log_dropped_total", "", Logger::getDropped());
+
+	writeHeader(out, "command_queue_latency_microseconds", "summary",
+		"Time from reading a command until the main loop queued its replies. The handoff to other event "
+		"loops and the socket write are not included.");
+	for (int i = 0; i < getCommandCount(); i++)
+	{
+		const LatencyHistogram &latency = _metrics.getLatency(i);
+		if (latency.getCount() == 0)
+			continue;
+		std::string labels = "command=\"" + commandName(i) + "\"";
+		for (double quantile : LATENCY_QUANTILES)
+		{
+			std::string q = std::to_string(quantile);
+			q.erase(q.find_last_not_of('0') + 1);
+			writeValue(out, "command_queue_latency_microseconds", labels + ",quantile=\"" + q + "\"",
+				latency.getPercentile(quantile * 100));
+		}
+		writeValue(out, "command_queue_latency_microseconds_sum", labels, latency.getSum());
+		writeValue(out, "command_queue_latency_microseconds_count", labels, latency.getCount());
+	}
+}
+
+/*Replies to STATS with the given query letter:
+	m	RPL_STATSCOMMANDS per command which was used
+	u	RPL_STATSUPTIME
+	p	RPL_STATSDEBUG lines with connections, traffic, send queues, disconnects and the latencies
+		until the main loop queued the replies (queue_latency_us, see recordLatencies)
+  Every query ends with RPL_ENDOFSTATS.*/
+void Server::writeStats(Client &client, char query)
+{
+	const std::string &nick = client.getNick();
+
+	if (query == 'm')
+	{
+		for (int i = 0; i < getCommandCount(); i++)
+		{
+			if (_metrics.getCommands(i) != 0)
+				MessageServerToClient(client, RPL_STATSCOMMANDS(nick, commandName(i), std::to_string(_metrics.getCommands(i))));
+		}
+	}
+	else if (query == 'u')
+	{
+		uint64_t seconds = (TimerWheel::monotonicMs() - _metrics.getStartedAt()) / 1000;
+		char uptime[64];
+		snprintf(uptime, sizeof(uptime), "%llu days %llu:%02llu:%02llu", static_cast<unsigned long long>(seconds / 86400),
+			static_cast<unsigned long long>(seconds / 3600 % 24), static_cast<unsigned long long>(seconds / 60 % 60),
+			static_cast<unsigned long long>(seconds % 60));
+		MessageServerToClient(client, RPL_STATSUPTIME(nick, std::string(uptime)));
+	}
+	else if (query == 'p')
+	{
+		uint64_t totals[7] = {};
+		for (const EventLoop *loop : _loops)
+		{
+			const LoopStats &stats = loop->getStats();
+			totals[0] += loop->getAcceptedTotal();
+			totals[1] += loop->getRejectedTotal();
+			totals[2] += loop->getAcceptRate();
+			totals[3] += stats.bytesIn.load(std::memory_order_relaxed);
+			totals[4] += stats.bytesOut.load(std::memory_order_relaxed);
+			totals[5] += stats.queuedBytes.load(std::memory_order_relaxed);
+			totals[6] = std::max<uint64_t>(totals[6], stats.queuePeak.load(std::memory_order_relaxed));
+		}
+		MessageServerToClient(client, RPL_STATSDEBUG(nick, "connections " + std::to_string(getConnectionCount())
+			+ " accepted " + std::to_string(totals[0]) + " rejected " + std::to_string(totals[1])
+			+ " accept_rate " + std::to_string(totals[2]) + "/s"));
+		MessageServerToClient(client, RPL_STATSDEBUG(nick, "bytes_in " + std::to_string(totals[3])
+			+ " bytes_out " + std::to_string(totals[4]) + " sendq " + std::to_string(totals[5])
+			+ " sendq_peak " + std::to_string(totals[6])));
+		MessageServerToClient(client, RPL_STATSDEBUG(nick, "broadcasts " + std::to_string(_metrics.getBroadcasts())
+			+ " fanout " + std::to_string(_metrics.getFanout())));
+		std::string disconnects = "disconnects";
+		for (int i = 0; i < DISCONNECT_REASONS; i++)
+		{
+			disconnectReason reason = static_cast<disconnectReason>(i);
+			disconnects += std::string(" ") + Metrics::getReasonName(reason) + " " + std::to_string(_metrics.getDisconnects(reason));
+		}
+		MessageServerToClient(client, RPL_STATSDEBUG(nick, disconnects));
+		for (int i = 0; i < getCommandCount(); i++)
+		{
+			const LatencyHistogram &latency = _metrics.getLatency(i);
+			if (latency.getCount() == 0)
+				continue;
+			MessageServerToClient(client, RPL_STATSDEBUG(nick, "queue_latency_us " + commandName(i)
+				+ " count " + std::to_string(latency.getCount())
+				+ " p50 " + std::to_string(latency.getPercentile(50))
+				+ " p99 " + std::to_string(latency.getPercentile(99))
+				+ " p99.9 " + std::to_string(latency.getPercentile(99.9))
+				+ " max " + std::to_string(latency.getMax())));
+		}
+	}
+	MessageServerToClient(client, RPL_ENDOFSTATS(nick, std::string(1, query)));
+}
@@ -13,43 +13,74 @@
 #pragma once
 
 #include "Channel.hpp"
+#include "Reply.hpp"
 #include <iostream>
 
+/*Every reply is built in place by a Reply (see Reply.hpp). The parameters are anything which
+  converts to std::string_view, so names are appended without temporary strings. The server's own
+  numerics and messages start with ":SERVER_NAME", messages relayed from a client with its cached
+  prefix (Client::getPrefix, ":nick!user@host").*/
+
+//general
+#define ERR_INPUTTOOLONG(nick)                                      Reply::server("417").param(nick).trailing("Input line was too long")
+#define ERR_UNKNOWNCOMMAND(nick, command)                           Reply::server("421").param(nick).param(command).trailing("Unknown command")
+#define ERR_NOTREGISTERED(nick)                                     Reply::server("451").param(nick).trailing("You have not registered")
+#define ERR_ALREADYREGISTRED(nick)                                  Reply::server("462").param(nick).trailing("You may not reregister")
+#define ERR_NOPRIVILEGES(nick)                                      Reply::server("481").param(nick).trailing("Permission Denied- You're not an IRC operator")
+#define ERR_NOOPERHOST(nick)                                        Reply::server("491").param(nick).trailing("No O-lines for your host")
+
+//operator
+#define RPL_YOUREOPER(nick)                                         Reply::server("381").param(nick).trailing("You are now an IRC operator")
+#define RPL_STATSCOMMANDS(nick, command, count)                     Reply::server("212").param(nick).param(command).param(count).param("0 0")
+#define RPL_ENDOFSTATS(nick, query)                                 Reply::server("219").param(nick).param(query).trailing("End of STATS report")
+#define RPL_STATSUPTIME(nick, uptime)                               Reply::server("242").param(nick).trailing("Server Up ").append(uptime)
+#define RPL_STATSDEBUG(nick, text)                                  Reply::server("249").param(nick).trailing(text)
+
 //nick
-#define ERR_NOSUCHNICK(nick, nicktofind)                            "401 " + nick + " " + nicktofind + " :No such nick/channel"
-#define ERR_NICKNAMEINUSE(oldnick, nick)                            "433 " + oldnick + " " + nick  + " :Nickname is already in use"
+#define ERR_NOSUCHNICK(nick, nicktofind)                            Reply::server("401").param(nick).param(nicktofind).trailing("No such nick/channel")
+#define ERR_TOOMANYTARGETS(nick, target)                            Reply::server("407").param(nick).param(target).trailing("Too many recipients")
+#define ERR_ERRONEUSNICKNAME(oldnick, nick)                         Reply::server("432").param(oldnick).param(nick).trailing("Erroneous nickname")
+#define ERR_NICKNAMEINUSE(oldnick, nick)                            Reply::server("433").param(oldnick).param(nick).trailing("Nickname is already in use")
 
 //channel
-#define RPL_CREATIONTIME(nickname, channelName, timestamp)          "329 " + nickname + " " + channelName + " " + timestamp
-#define ERR_NOSUCHCHANNEL(nick, channelname)                        "403 " + nick + " " + channelname + " :No such channel"
-#define ERR_USERNOTINCHANNEL(clientnick, usernickname, channelname) "441 " + nick + " " + usernickname + " " + channelname + " :They aren't on that channel"
-#define ERR_NOTONCHANNEL(clientnick, channelname)                   "442 " + clientnick + " " + channelname + " :They aren't on that channel"
-#define ERR_USERONCHANNEL(clientnick, usernick, channelname)        "443 " + clientnick + " " + nick + " " + channelName + " :is already on channel"
-#define ERR_CHANOPRIVSNEEDED(nick, channelname)                     "482 " + nick + " " + channelname + " :You're not channel operator"
-#define ERR_NONICKNAMEGIVEN()                                       "431 :Nickname not given"
-#define ERR_PASSWDMISMATCH(source)                                  "464 " + source + " :Password is incorrect"
-#define ERR_NEEDMOREPARAMS(nickname)                                "461 " + nickname + " MODE :Not enough parameters"
+#define RPL_CREATIONTIME(nickname, channelName, timestamp)          Reply::server("329").param(nickname).param(channelName).param(timestamp)
+#define ERR_NOSUCHCHANNEL(nick, channelname)                        Reply::server("403").param(nick).param(channelname).trailing("No such channel")
+#define ERR_USERNOTINCHANNEL(clientnick, usernickname, channelname) Reply::server("441").param(clientnick).param(usernickname).param(channelname).trailing("They aren't on that channel")
+#define ERR_NOTONCHANNEL(clientnick, channelname)                   Reply::server("442").param(clientnick).param(channelname).trailing("They aren't on that channel")
+#define ERR_USERONCHANNEL(clientnick, usernick, channelname)        Reply::server("443").param(clientnick).param(usernick).param(channelname).trailing("is already on channel")
+#define ERR_CHANOPRIVSNEEDED(nick, channelname)                     Reply::server("482").param(nick).param(channelname).trailing("You're not channel operator")
+#define ERR_NONICKNAMEGIVEN()                                       Reply::server("431").trailing("Nickname not given")
+#define ERR_PASSWDMISMATCH(source)                                  Reply::server("464").param(source).trailing("Password is incorrect")
+#define ERR_NEEDMOREPARAMS(nickname, command)                       Reply::server("461").param(nickname).param(command).trailing("Not enough parameters")
 
 //modes
-#define RPL_CHANNELMODEIS(nickname, channelName, channelModes)      "324 " + nickname + " " + channelName + " " + channelModes
-#define ERR_CHANNELISFULL(nickname, channelName)                    "471 " + nickname + " " + channelName + " :Cannot join channel (+l) - channel is full, try again later"
-#define ERR_UNKNOWNMODE(nickname, mode)                             "472 " + nickname + " " + mode + " :is an unknown mode char to me"
-#define ERR_INVITEONLYCHAN(nickname, channelName)                   "473 " + nickname + " " + channelName + " :Cannot join channel (+i) - you must be invited"
-#define ERR_BADCHANNELKEY(nickname, channelName)                    "475 " + nickname + " " + channelName + " :Cannot join channel (+k) - bad key"
+#define RPL_CHANNELMODEIS(nickname, channelName, channelModes)      Reply::server("324").param(nickname).param(channelName).param(channelModes)
+#define ERR_CHANNELISFULL(nickname, channelName)                    Reply::server("471").param(nickname).param(channelName).trailing("Cannot join channel (+l) - channel is full, try again later")
+#define ERR_UNKNOWNMODE(nickname, mode)                             Reply::server("472").param(nickname).param(mode).trailing("is an unknown mode char to me")
+#define ERR_INVITEONLYCHAN(nickname, channelName)                   Reply::server("473").param(nickname).param(channelName).trailing("Cannot join channel (+i) - you must be invited")
+#define ERR_BADCHANNELKEY(nickname, channelName)                    Reply::server("475").param(nickname).param(channelName).trailing("Cannot join channel (+k) - bad key")
 
 /* Numeric Responses */
-#define RPL_WELCOME(nickname)                                       "001 " + nickname + " :Welcome " + nickname + " to the ft_irc network"
-#define RPL_PASSWDOK()                                              "NOTICE * Password is perfecto!"
-#define RPL_PASSWDREQUEST()                                         "NOTICE * :This server requires a password. Please send: PASS <password>"
-#define RPL_NICKREQUEST()                                           "NOTICE * :This server requires a user nickname. Please send: NICK <nickname>"
-#define RPL_USERNAMEREQUEST()                                       "NOTICE * :This server requires a user user name. Please send: User <username username localhost :Name>"
-#define RPL_NAMREPLY(nickname, channelname, users)                  "353 " + nickname + " @ " + channelname + " :@" + users
-#define RPL_ENDOFNAMES(source, channelname)                         "366 " + source + " " + channelname + " :End of /NAMES list."
+#define RPL_WELCOME(nickname)                                       Reply::server("001").param(nickname).trailing("Welcome ").append(nickname).append(" to the ft_irc network")
+#define RPL_ISUPPORT(nickname, tokens)                              Reply::server("005").param(nickname).param(tokens).trailing("are supported by this server")
+#define RPL_PASSWDOK()                                              Reply::server("NOTICE").param("*").param("Password is perfecto!")
+#define RPL_PASSWDREQUEST()                                         Reply::server("NOTICE").param("*").trailing("This server requires a password. Please send: PASS <password>")
+#define RPL_NICKREQUEST()                                           Reply::server("NOTICE").param("*").trailing("This server requires a user nickname. Please send: NICK <nickname>")
+#define RPL_USERNAMEREQUEST()                                       Reply::server("NOTICE").param("*").trailing("This server requires a user user name. Please send: User <username username localhost :Name>")
+#define RPL_NAMREPLY(nickname, channelname, users)                  Reply::server("353").param(nickname).param("@").param(channelname).trailing(users)
+#define RPL_ENDOFNAMES(source, channelname)                         Reply::server("366").param(source).param(channelname).trailing("End of /NAMES list.")
 
 /* Command Responses */
-#define RPL_INVITING(clientnick, nick, channelname)		            "341 " + clientnick + " " + nick + " " + channelname
-#define RPL_NICK(oldnick, username, nick)				            ":" + oldNick + " NICK :" + nick
-#define RPL_TOPIC(clientnick, channelname, newtopic)	            ":" + clientnick + " TOPIC " + channelName + " " + newtopic
-#define RPL_JOIN(source, channel)                                   ":" + source + " JOIN :" + channel
-#define RPL_KICK(source, channel, target, reason)                   ":" + source + " KICK " + channel + " " + target + " :" + reason
-#define RPL_PRIVMSG(clientnick, nick, message)                      ":" + clientnick + " PRIVMSG " + nick + " :" + message
+#define RPL_INVITING(clientnick, nick, channelname)                 Reply::server("341").param(clientnick).param(nick).param(channelname)
+#define RPL_NICK(oldprefix, nick)                                   Reply(oldprefix).param("NICK").trailing(nick)
+#define RPL_TOPIC(prefix, channelname, newtopic)                    Reply(prefix).param("TOPIC").param(channelname).trailing(newtopic)
+#define RPL_JOIN(prefix, channel)                                   Reply(prefix).param("JOIN").trailing(channel)
+#define RPL_KICK(prefix, channel, target, reason)                   Reply(prefix).param("KICK").param(channel).param(target).trailing(reason)
+#define RPL_MODE(prefix, channel, modes)                            Reply(prefix).param("Mode").param(channel).param(modes)
+#define RPL_PRIVMSG(prefix, nick, message)                          Reply(prefix).param("PRIVMSG").param(nick).trailing(message)
+#define RPL_NOTICE(prefix, nick, message)                           Reply(prefix).param("NOTICE").param(nick).trailing(message)
+#define RPL_QUIT(prefix, reason)                                    Reply(prefix).param("QUIT").trailing(reason)
+#define RPL_PING(token)                                             Reply::server("PING").trailing(token)
+#define RPL_PONG(token)                                             Reply::server("PONG").param(SERVER_NAME).trailing(token)
+#define RPL_CAP(nick, subcommand, caps)                             Reply::server("CAP").param(nick).param(subcommand).trailing(caps)
+#define ERR_CLOSINGLINK(nick, reason)                               Reply::server("ERROR").trailing("Closing Link: ").append(nick).append(" (").append(reason).append(")")
@@ -11,18 +11,22 @@
 /* **************************************************************************************** */
 
 #include "Server.hpp"
+#include "response.hpp"
 #include <sys/socket.h>
-#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
 #include <system_error>
 
 /*Signal handler for SIGINT, SIGTERM, SIGQUIT, and SIGSEGV*/
 volatile sig_atomic_t		server_running;
 
-/*Creates a server socket (AF_INET for IPv4), with tcp socket type (SOCK_STREAM) and sets socket
-  options (SO_REUSEADDR for being able to reuse address and port if in time_wait state)*/
-int Server::createServerSocket()
+/*Creates a non-blocking server socket (AF_INET for IPv4), with tcp socket type (SOCK_STREAM) and sets
+  socket options (SO_REUSEADDR for being able to reuse address and port if in time_wait state,
+  SO_REUSEPORT when several event loops listen on the same port)*/
+int Server::createServerSocket(bool reusePort)
 {
-	int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+	int server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
 	if (server_fd == -1)
 	{
 		throw std::runtime_error("Socket operation failed: Connection refused");
@@ -33,11 +37,17 @@ int Server::createServerSocket()
 		close(server_fd);
 		throw std::system_error(errno, std::generic_category(), "setsockopt failed: Unable to set SO_REUSEADDR");
 	}
+	if (reusePort && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1)
+	{
+		close(server_fd);
+		throw std::system_error(errno, std::generic_category(), "setsockopt failed: Unable to set SO_REUSEPORT");
+	}
 	return server_fd;
 }
 
 /*Binds and listens on the server socket. Defines and stores server's socket address, uses INADDR_ANY
-  to avoid binding to a particular IP but instead make server listen to all available IPs*/
+  to avoid binding to a particular IP but instead make server listen to all available IPs. The
+  backlog (--backlog) holds the connections the event loop did not accept yet.*/
 void Server::bindAndListen(int server_fd)
 {
 	sockaddr_in server_addr = {};
@@ -47,78 +57,136 @@ void Server::bindAndListen(int server_fd)
 
 	if (bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1)
 	{
-		perror("Bind failed");
+		LOG(LEVEL_ERROR, LOG_CORE, "Bind failed: " << std::strerror(errno));
 		close(server_fd);
 		throw std::system_error(errno, std::generic_category(), "Failed to bind socket");
 	}
 
-	if (listen(server_fd, MAX_CLIENTS) == -1)
+	if (listen(server_fd, _config.listenBacklog) == -1)
 	{
 		close(server_fd);
 		throw std::system_error(errno, std::generic_category(), "Listen failed");
 	}
+}
 
-	std::cout << "Server is listening on port " << _port << "..." << std::endl;
+/*Marks the client's session for removal. The client object stays valid until the end of the
+  main loop iteration, so handlers and loops over channel members may still refer to it. The
+  reason is counted in the metrics. Only called on the main loop.*/
+void Server::disconnectClient(Client &client, disconnectReason reason)
+{
+	if (client.getState() == DISCONNECTED)
+		return;
+	_metrics.disconnected(reason);
+	markDisconnected(client);
 }
 
-/*Handle a new client connection*/
-void Server::handleNewClient(int server_fd)
+/*The client leaves the network: every client sharing a channel with it gets one QUIT line, then it
+  is removed from its channels right away so the removal in reapClients has nothing left to
+  announce. Does not close the connection.*/
+void Server::quitClient(Client &client, const std::string &reason)
 {
-	
-	sockaddr_in client_addr = {};
-	socklen_t client_len = sizeof(client_addr);
-	int client_fd = accept(server_fd, (struct sockaddr *)&client_addr, &client_len);
-	if (client_fd == -1)
-	{
-		perror("Accept failed");
+	if (client.getJoinedChannels().empty())
 		return;
+	sendToNeighbors(client, RPL_QUIT(client.getPrefix(), reason));
+	removeFromAllChannels(&client);
+}
+
+void Server::markDisconnected(Client &client)
+{
+	client.setState(DISCONNECTED);
+	_pendingRemoval.push_back(&client);
+}
+
+/*The event loop owning the client closed the connection (read or write error, send queue
+  overflow or a CLOSE asked for by reapClients). The session is removed, then the client is
+  released to its loop which deletes it. The loop counted the reason already.*/
+void Server::clientClosed(Client &client)
+{
+	if (_capture != nullptr)
+		captureTraffic(CAPTURE_DISCONNECT, client);
+	if (client.getState() != DISCONNECTED)
+	{
+		quitClient(client, "Connection closed");
+		markDisconnected(client);
 	}
-	std::cout << "New client connected." << std::endl;
-	_clients.push_back(new Client(client_fd, client_addr));
-	_clients.back()->setState(REGISTERING);
+	_pendingRelease.push_back(&client);
 }
 
-/*Handles events on the server socket and client sockets, using revents (indicating which event
-  occured on the file descriptor) and POLLIN (readable data available). Uses recv to read data
-  from client socket and stores it in buffer for further processing.*/
-void Server::handleEvents(std::vector<struct pollfd> &fds)
+/*Removes the sessions marked by disconnectClient from all channels and the nick index and asks
+  their event loops to close the connections, the replies queued before (e.g. error replies) are
+  still sent. Clients whose connection is already closed are handed back to their loop, after
+  that the main loop does not refer to them anymore.*/
+void Server::reapClients()
 {
-	for (size_t i = 1; i < fds.size(); ++i)
+	for (Client *client : _pendingRemoval)
 	{
-		if (fds[i].revents & POLLIN)
-		{
-			char buffer[BUFFER_SIZE];
-			ssize_t bytes_read = recv(fds[i].fd, buffer, BUFFER_SIZE - 1, 0);
-			if (bytes_read <= 0)
-			{
-				std::cout << "Client disconnected." << std::endl;
-				close(fds[i].fd);
-				_clients.erase(_clients.begin() + i - 1);
-			}
-			else
-			{
-				buffer[bytes_read] = '\0';
-				std::string message(buffer);
-				handleClientMessage(*_clients[i - 1], message);
-			}
-		}
+		_timers.cancel(client->getTimer());
+		removeFromAllChannels(client);
+		unregisterNick(client);
+		client->getTransport()->postFromMain({LOOP_CLOSE, client, nullptr});
 	}
+	_pendingRemoval.clear();
+	for (Client *client : _pendingRelease)
+		client->getTransport()->postFromMain({LOOP_RELEASE, client, nullptr});
+	_pendingRelease.clear();
 }
 
-void Server::cleanupResources(int server_fd)
+EventLoop* Server::getMainLoop() { return (_loops[0]); }
+
+/*Counts a newly accepted connection. Returns false without counting it if maxClients connections
+  are open already. Called by the event loops on their threads.*/
+bool Server::reserveConnection()
 {
-	for (auto &client : _clients)
+	if (_connections.fetch_add(1, std::memory_order_relaxed) >= _config.maxClients)
 	{
-		close(client->getFd());
-		delete client;
+		_connections.fetch_sub(1, std::memory_order_relaxed);
+		return (false);
 	}
-	_clients.clear();
+	return (true);
+}
+
+void Server::releaseConnection() { _connections.fetch_sub(1, std::memory_order_relaxed); }
+
+int Server::getConnectionCount() const { return (_connections.load(std::memory_order_relaxed)); }
+
+/*Handles the messages the other event loops queued for the main loop*/
+void Server::drainLoops()
+{
+	for (size_t i = 1; i < _loops.size(); i++)
+		_loops[i]->drainToMain();
+}
+
+/*Wakes up the event loops the main loop queued messages for*/
+void Server::notifyLoops()
+{
+	for (size_t i = 1; i < _loops.size(); i++)
+		_loops[i]->notify();
+}
+
+/*Stops and joins the event loop threads, then deletes the loops (closing the client and
+  listening sockets) and the channels. The admin endpoint is stopped first, it reads the loops. The timers are
+  unlinked before the clients are deleted.*/
+void Server::cleanupResources()
+{
+	delete _admin;
+	_admin = nullptr;
+	for (size_t i = 1; i < _loops.size(); i++)
+		_loops[i]->stop();
+	for (size_t i = 1; i < _loops.size(); i++)
+		_loops[i]->join();
+	_timers.clear();
+	stopCapture();
+	for (EventLoop *loop : _loops)
+		delete loop;
+	_loops.clear();
 	for (auto &channel : _channels)
 	{
-		delete channel; 
+		delete channel.second; 
 	}
 	_channels.clear(); 
-	close(server_fd);
+	_nicknames.clear();
+	_pendingRemoval.clear();
+	_pendingRelease.clear();
 }
 
 void handle_sig(int sig) 
@@ -137,45 +205,53 @@ void HandleSignals()
 	signal(SIGTERM, handle_sig); 
 	signal(SIGQUIT, handle_sig); 
 	signal(SIGSEGV, handle_sig); 
+	signal(SIGPIPE, SIG_IGN);
 }
 
-/*Adds each server socket and each client socket to list of monitored fds and sets POLLIN respectively
-  for checking incoming data. Uses poll() system call for monitoring multiple fds(sockets) simultaneaously.
-  It checks whether one or more fds are ready for I/O operations otherwise blocks system until readyness.
-  If poll not successful as disrupted by signal, skips rest of loop with continue for next iteration.
-  If successful, uses revents and POLLIN for server socket, checking that a new event occured and
-  that a new connection is ready to be accepted. Events on client sockets handled by handleEvents method.*/
+/*Creates one event loop per configured thread, each with a listening socket of its own. With more
+  than one loop the sockets share the port through SO_REUSEPORT and the kernel spreads new
+  connections over them. Loop 0, the main loop, runs on the calling thread and owns channels, nicks
+  and sessions, the others run on threads of their own and only do socket I/O (accept, read, line
+  framing, write). Signals are blocked on those threads so the shutdown signal interrupts the main
+  loop, which then stops the others.*/
 void Server::runServer()
 {
+	int loops = _config.threads;
 
-	int server_fd = createServerSocket();
-	bindAndListen(server_fd);
 	HandleSignals();
-
-	std::vector<struct pollfd> fds;
-	while (server_running)
+	try
 	{
-		
-		fds.clear();
-		fds.push_back({server_fd, POLLIN, 0}); 
-
-		for (const auto &client : _clients)
-		{
-			fds.push_back({client->getFd(), POLLIN, 0});
-		}
-		int poll_result = poll(fds.data(), fds.size(), -1);
-		if (poll_result == -1)
+		for (int i = 0; i < loops; i++)
 		{
-			if (errno == EINTR) 
-				continue;
-			perror("Poll failed");
-			break;
+			int server_fd = createServerSocket(loops > 1);
+			bindAndListen(server_fd);
+			_loops.push_back(new EventLoop(*this, i, server_fd, _config.ioBackend));
 		}
-		if (fds[0].revents & POLLIN )
-		{
-			handleNewClient(server_fd);
-		}
-		handleEvents(fds);
+		if (_config.metricsPort != 0)
+			_admin = new AdminEndpoint(*this, _config.metricsPort);
+		startCapture();
+	}
+	catch (...)
+	{
+		cleanupResources();
+		throw;
 	}
-	cleanupResources(server_fd);
+	LOG(LEVEL_INFO, LOG_CORE, "Server is listening on port " << _port << "...");
+	LOG(LEVEL_INFO, LOG_CORE, "Using " << _loops[0]->getBackendName() << " event backend, " << loops
+		<< " event loop(s)");
+	if (_admin != nullptr)
+		LOG(LEVEL_INFO, LOG_CORE, "Metrics on http://127.0.0.1:" << _config.metricsPort << "/metrics");
+	sigset_t blocked, previous;
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGTERM);
+	sigaddset(&blocked, SIGQUIT);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	for (size_t i = 1; i < _loops.size(); i++)
+		_loops[i]->start();
+	if (_admin != nullptr)
+		_admin->start();
+	pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+	_loops[0]->run();
+	cleanupResources();
 }
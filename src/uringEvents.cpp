@@ -0,0 +1,247 @@
+/* **************************************************************************************** */
+/*                                                                                          */
+/*                                                        ::::::::::: :::::::::   ::::::::  */
+/*                                                           :+:     :+:    :+: :+:    :+:  */
+/*                                                          +:+     +:+    +:+ +:+          */
+/*                                                         +#+     +#++:++#:  +#+           */
+/*  By: Timo Saari<tsaari@student.hive.fi>,               +#+     +#+    +#+ +#+            */
+/*      Matti Rinkinen<mrinkine@student.hive.fi>,        #+#     #+#    #+# #+#    #+#      */
+/*      Marius Meier<mmeier@student.hive.fi>        ########### ###    ###  ########        */
+/*                                                                                          */
+/* **************************************************************************************** */
+
+#include "EventLoop.hpp"
+#include "Server.hpp"
+#include <sys/socket.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+/*The user data of a request holds its type, the generation of the fd slot and the fd (for sends
+  the index of the UringSend instead)*/
+enum uringRequest
+{
+	URING_ACCEPT = 1,
+	URING_WAKE,
+	URING_RECV,
+	URING_SEND,
+	URING_LISTEN_POLL
+};
+
+const uint32_t	URING_GENERATION_MASK = 0xFFFFFF;
+
+static uint64_t	packRequest(uringRequest type, uint32_t generation, uint32_t id)
+{
+	return ((static_cast<uint64_t>(type) << 56)
+		| (static_cast<uint64_t>(generation & URING_GENERATION_MASK) << 32) | id);
+}
+
+static uringRequest	requestType(uint64_t userData) { return (static_cast<uringRequest>(userData >> 56)); }
+
+static uint32_t	requestGeneration(uint64_t userData) { return ((userData >> 32) & URING_GENERATION_MASK); }
+
+static uint32_t	requestId(uint64_t userData) { return (static_cast<uint32_t>(userData)); }
+
+/*Creates the ring and arms the multishot accept and the wake fd read. Returns false if io_uring
+  is not usable, the loop then falls back to epoll.*/
+bool	EventLoop::setupUring()
+{
+	try {
+		_ring = new IoUring();
+	}
+	catch (const std::system_error &e) {
+		LOG(LEVEL_WARN, LOG_CORE, e.what() << ", falling back to epoll");
+		return (false);
+	}
+	_ring->prepareAccept(_listenFd, packRequest(URING_ACCEPT, 0, 0));
+	_ring->prepareRead(_wakeFd, &_wakeValue, sizeof(_wakeValue), packRequest(URING_WAKE, 0, 0));
+	return (true);
+}
+
+/*Handles the completions reaped by the last wait*/
+void	EventLoop::handleCompletions()
+{
+	struct io_uring_cqe	cqe;
+
+	while (_ring->nextCompletion(cqe))
+		handleCompletion(cqe);
+}
+
+void	EventLoop::handleCompletion(const struct io_uring_cqe &cqe)
+{
+	switch (requestType(cqe.user_data))
+	{
+		case URING_ACCEPT:
+			acceptCompleted(cqe);
+			break;
+		case URING_WAKE:
+			wakeCompleted(cqe);
+			break;
+		case URING_RECV:
+			recvCompleted(cqe);
+			break;
+		case URING_SEND:
+			sendCompleted(cqe);
+			break;
+		case URING_LISTEN_POLL:
+			_ring->prepareAccept(_listenFd, packRequest(URING_ACCEPT, 0, 0));
+			break;
+	}
+}
+
+/*One accepted connection. The multishot accept does not report the peer address, it is looked up
+  with getpeername(). The request is armed again if the kernel ended it. Out of file descriptors an
+  accept fails at once even with an empty backlog, so after shedding a connection it is only armed
+  again once the listening socket is readable.*/
+void	EventLoop::acceptCompleted(const struct io_uring_cqe &cqe)
+{
+	if (cqe.res >= 0)
+	{
+		sockaddr_in client_addr = {};
+		socklen_t client_len = sizeof(client_addr);
+		getpeername(cqe.res, (struct sockaddr *)&client_addr, &client_len);
+		acceptClient(cqe.res, client_addr);
+	}
+	else if (cqe.res == -EMFILE || cqe.res == -ENFILE)
+	{
+		errno = -cqe.res;
+		shedConnection();
+		if (!(cqe.flags & IORING_CQE_F_MORE))
+			return (_ring->preparePoll(_listenFd, POLLIN, packRequest(URING_LISTEN_POLL, 0, 0)));
+	}
+	else if (cqe.res != -EAGAIN && cqe.res != -EINTR && cqe.res != -ECONNABORTED)
+	{
+		LOG(LEVEL_ERROR, LOG_NET, "Accept failed: " << std::strerror(-cqe.res));
+	}
+	if (!(cqe.flags & IORING_CQE_F_MORE))
+		_ring->prepareAccept(_listenFd, cqe.user_data);
+}
+
+void	EventLoop::wakeCompleted(const struct io_uring_cqe &cqe)
+{
+	if (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR)
+	{
+		LOG(LEVEL_ERROR, LOG_CORE, "eventfd read failed: " << std::strerror(-cqe.res));
+	}
+	_wakePending.exchange(false);
+	_ring->prepareRead(_wakeFd, &_wakeValue, sizeof(_wakeValue), cqe.user_data);
+}
+
+/*Data received into a provided buffer. It is copied into the client's receive buffer in chunks
+  which fit, the complete lines are passed on after every chunk and the provided buffer is given
+  back to the kernel right away. ENOBUFS (all provided buffers in use) only ends the request, it
+  is armed again like a request the kernel ended for other reasons.*/
+void	EventLoop::recvCompleted(const struct io_uring_cqe &cqe)
+{
+	Client	*client = getCompletionClient(requestId(cqe.user_data), requestGeneration(cqe.user_data));
+	bool	reading = (client != nullptr && !client->isClosing());
+
+	if (cqe.flags & IORING_CQE_F_BUFFER)
+	{
+		uint16_t	id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+		const char	*data = _ring->getBuffer(id);
+		size_t		left = (cqe.res > 0) ? cqe.res : 0;
+		uint64_t	receivedAt = Metrics::monotonicMicros();
+
+		while (reading && left > 0)
+		{
+			size_t bytes = client->getRecvBuffer().append(data, left);
+			data += bytes;
+			left -= bytes;
+			reading = processLines(*client, receivedAt);
+		}
+		_ring->recycleBuffer(id);
+		if (cqe.res > 0)
+			addCounter(_stats.bytesIn, cqe.res);
+	}
+	if (!reading)
+		return;
+	if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -EINTR))
+	{
+		LOG(LEVEL_INFO, LOG_NET, "Client disconnected on fd " << client->getFd());
+		_server.getMetrics().disconnected(cqe.res == 0 ? DISCONNECT_PEER_CLOSED : DISCONNECT_READ_ERROR);
+		closeClient(*client);
+	}
+	else if (!(cqe.flags & IORING_CQE_F_MORE))
+		armRecv(*client);
+}
+
+/*A send request finished, the written bytes are removed from the queue. Whatever is left or was
+  queued in the meantime is sent with the flushes at the end of the iteration.*/
+void	EventLoop::sendCompleted(const struct io_uring_cqe &cqe)
+{
+	uint32_t	slot = requestId(cqe.user_data);
+	UringSend	*send = _sends[slot];
+	Client		*client = getCompletionClient(send->fd, send->generation);
+
+	send->lines.clear();
+	_freeSends.push_back(slot);
+	if (client == nullptr)
+		return;
+	client->setWriteInterest(false);
+	if (client->isClosing())
+		return;
+	if (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR)
+	{
+		_server.getMetrics().disconnected(DISCONNECT_WRITE_ERROR);
+		closeClient(*client);
+		return;
+	}
+	if (cqe.res > 0)
+	{
+		client->getSendQueue().consume(cqe.res);
+		sentFromQueue(cqe.res);
+	}
+	if (!client->getSendQueue().empty() && !client->isFlushPending())
+	{
+		client->setFlushPending(true);
+		_pendingFlush.push_back(client);
+	}
+}
+
+/*Returns the client a completion belongs to, nullptr if its connection was closed in the meantime
+  (the fd may already belong to a new connection, its slot has another generation then)*/
+Client	*EventLoop::getCompletionClient(uint32_t fd, uint32_t generation)
+{
+	if (fd >= _clients.size() || (_generations[fd] & URING_GENERATION_MASK) != (generation & URING_GENERATION_MASK))
+		return (nullptr);
+	return (_clients[fd]);
+}
+
+void	EventLoop::armRecv(Client &client)
+{
+	int fd = client.getFd();
+
+	_ring->prepareRecv(fd, packRequest(URING_RECV, _generations[fd], fd));
+}
+
+/*Queues one send request for the front of the client's send queue, at most one is in flight per
+  client (marked by the write interest). The request is submitted together with the requests of all
+  other clients at the next wait.*/
+void	EventLoop::submitSend(Client &client)
+{
+	uint32_t	slot;
+
+	if (client.getWriteInterest() || client.getSendQueue().empty())
+		return;
+	if (_freeSends.empty())
+	{
+		slot = _sends.size();
+		_sends.push_back(new UringSend());
+	}
+	else
+	{
+		slot = _freeSends.back();
+		_freeSends.pop_back();
+	}
+	UringSend *send = _sends[slot];
+	send->fd = client.getFd();
+	send->generation = _generations[send->fd];
+	int count = client.getSendQueue().prepare(send->iov, SENDQ_IOV_BATCH, &send->lines);
+	send->message = {};
+	send->message.msg_iov = send->iov;
+	send->message.msg_iovlen = count;
+	_ring->prepareSend(send->fd, &send->message, packRequest(URING_SEND, 0, slot));
+	client.setWriteInterest(true);
+}